@@ -0,0 +1,341 @@
+// Microbenchmarks for the assembler and the pipeline simulator.
+//   sim_bench [--quick] [--repeat n] [--json out.json] [--baseline base.json [--threshold pct]]
+//             [any riscv_cli pipeline option]
+// Measures assembler throughput (lines/s) on generated sources of 1K..1M lines,
+// step() throughput (cycles/s) on hazard-, branch-, memory- and compute-heavy programs,
+// run_functional() and run_jit() throughput (instructions/s) on the same programs, and
+// initialize/reset latency. Each figure is the best of --repeat runs. --json writes
+// the results; --baseline compares against a file written that way and exits 1 if
+// any result is worse by more than --threshold percent (default 10).
+#include "../hpp_files/assembler.hpp"
+#include "../hpp_files/parser.hpp"
+#include "../hpp_files/session.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+
+struct Result {
+    string name;
+    string unit;
+    double value;
+    bool   higher_is_better;
+};
+
+static double seconds(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Best (shortest) time of `repeat` calls of fn
+static double bestOf(unsigned repeat, const function<void()>& fn) {
+    double best = 1e300;
+    for (unsigned r = 0; r < repeat; r++) {
+        auto start = chrono::steady_clock::now();
+        fn();
+        best = min(best, seconds(start));
+    }
+    return best;
+}
+
+// --- Program generators ---
+// The assembler source and the hazard, branch and memory programs keep to lw sw slt sll
+// slli beq blt, as they were written before the rest of RV32I and RV32M, so their
+// figures stay comparable with older baselines. The compute program covers the rest.
+
+// Exactly `lines` source lines: a small .data section, then blocks of mixed
+// instructions, each block opened by a label that the block's branches use
+static string assemblerSource(size_t lines) {
+    static const char* body[] = {
+        "    lw x1, 0(x0)", "    lw x2, 4(x0)", "    slt x3, x1, x2", "    sll x4, x1, x3",
+        "    slli x5, x4, 3", "    sw x5, 8(x0)", "    beq x3, x0, B%zu", "    blt x1, x2, B%zu",
+    };
+    stringstream src;
+    src << ".data\n" << "a: .word 7\n" << "b: .word 0x10\n" << "c: .word 0\n" << ".text\n";
+    size_t written = 5, block = 0;
+    char buf[64];
+    while (written < lines) {
+        src << "B" << block << ":\n";
+        written++;
+        for (size_t i = 0; i < 31 && written < lines; i++, written++) {
+            snprintf(buf, sizeof(buf), body[i % 8], block);
+            src << buf << "\n";
+        }
+        block++;
+    }
+    return src.str();
+}
+
+// Back-to-back RAW dependences through loads and ALU ops
+static string hazardProgram(int blocks) {
+    stringstream src;
+    src << ".data\n" << "a: .word 7\n" << "b: .word 9\n" << ".text\n";
+    for (int i = 0; i < blocks; i++) {
+        src << "lw x1, 0(x0)\n" << "lw x2, 4(x0)\n" << "slt x3, x1, x2\n" << "sll x4, x1, x3\n" << "sw x4, 8(x0)\n";
+    }
+    return src.str();
+}
+
+// Copies of a three-deep loop nest (doubling counters, ~30 iterations per level)
+static string branchProgram(int nests) {
+    stringstream src;
+    src << ".data\n" << "limit: .word 1073741824\n" << "one: .word 1\n" << "inner: .word 1048576\n" << ".text\n";
+    src << "lw x1, 0(x0)\n" << "lw x6, 8(x0)\n";
+    for (int n = 0; n < nests; n++) {
+        src << "lw x5, 4(x0)\n";
+        src << "O" << n << ":\n" << "lw x7, 4(x0)\n";
+        src << "M" << n << ":\n" << "lw x2, 4(x0)\n";
+        src << "I" << n << ":\n" << "slli x2, x2, 1\n" << "slt x3, x2, x6\n" << "blt x2, x6, I" << n << "\n";
+        src << "slli x7, x7, 2\n" << "blt x7, x6, M" << n << "\n";
+        src << "slli x5, x5, 1\n" << "blt x5, x1, O" << n << "\n";
+    }
+    return src.str();
+}
+
+// Loads and stores spread over eight 4 KiB pages through base registers
+static string memoryProgram(int blocks) {
+    stringstream src;
+    src << ".data\n";
+    for (int b = 0; b < 8; b++) src << "base" << b << ": .word " << 0x1000 * (b + 1) << "\n";
+    src << ".text\n";
+    for (int b = 0; b < 8; b++) src << "lw x" << 10 + b << ", " << 4 * b << "(x0)\n";
+    for (int i = 0; i < blocks; i++) {
+        int off = (i * 36) % 2048 & ~3;
+        src << "lw x1, " << off << "(x10)\n" << "sw x1, " << off << "(x11)\n"
+            << "lw x2, " << off << "(x12)\n" << "sw x2, " << off << "(x13)\n"
+            << "lw x3, " << off << "(x14)\n" << "sw x3, " << off << "(x15)\n"
+            << "lw x4, " << off << "(x16)\n" << "sw x4, " << off << "(x17)\n";
+    }
+    return src.str();
+}
+
+// A counted loop of RV32M multiplies and divides feeding the other ALU forms, with a
+// call (JAL/JALR) to a leaf that goes through byte and halfword loads and stores
+static string computeProgram(int iterations) {
+    stringstream src;
+    src << ".data\n" << "iters: .word " << iterations << "\n" << "seed: .word 0x12345\n" << ".text\n";
+    src << "lw x20, 0(x0)\n" << "lw x5, 4(x0)\n" << "lui x21, 0x9E37\n" << "addi x21, x21, 0x79B\n"
+        << "addi x22, x0, 7\n" << "jal x0, L\n";
+    src << "F:\n" << "sb x5, 16(x0)\n" << "sh x13, 18(x0)\n" << "lbu x23, 16(x0)\n" << "lh x24, 18(x0)\n"
+        << "add x5, x5, x23\n" << "xor x5, x5, x24\n" << "auipc x25, 0\n" << "jalr x0, 0(ra)\n";
+    src << "L:\n" << "mul x6, x5, x21\n" << "mulh x7, x5, x21\n" << "mulhu x8, x6, x21\n"
+        << "div x9, x6, x22\n" << "rem x10, x6, x22\n" << "divu x11, x7, x22\n"
+        << "add x5, x6, x9\n" << "sub x12, x5, x10\n" << "xor x13, x12, x11\n" << "or x14, x13, x8\n"
+        << "and x15, x14, x5\n" << "srai x16, x15, 3\n" << "srl x17, x14, x22\n" << "sltu x18, x16, x17\n"
+        << "addi x5, x5, 1\n" << "jal ra, F\n" << "addi x20, x20, -1\n" << "bne x20, x0, L\n";
+    return src.str();
+}
+
+// --- Benchmarks ---
+
+static void benchAssembler(vector<Result>& results, const vector<size_t>& sizes, unsigned repeat) {
+    filesystem::path path = filesystem::temp_directory_path() / "sim_bench_source.s";
+    for (size_t lines : sizes) {
+        {
+            ofstream out(path);
+            out << assemblerSource(lines);
+        }
+        size_t instructions = 0;
+        double t = bestOf(repeat, [&]() {
+            instructions = assembleFile(path.string()).machine_code.size();
+        });
+        results.push_back({"assemble/" + to_string(lines) + "_lines", "lines/s", lines / t, true});
+        cerr << "  assemble " << lines << " lines (" << instructions << " instructions): " << t * 1000.0 << " ms\n";
+    }
+    filesystem::remove(path);
+}
+
+static void benchStep(vector<Result>& results, const string& name, const string& source,
+                      const SimulatorConfig& config, unsigned repeat) {
+    Session session(assembleProgram(source), config);
+    RISCV_Simulator& sim = session.simulator();
+    sim.set_trace(TraceLevel::Off);
+
+    // Each run is followed by a timed reset: restoring the post-load snapshot after a
+    // full run, as the web UI's reset does
+    uint64_t cycles = 0;
+    double t = 1e300, reset = 1e300;
+    for (unsigned r = 0; r < repeat; r++) {
+        auto start = chrono::steady_clock::now();
+        cycles = sim.run();
+        t = min(t, seconds(start));
+        start = chrono::steady_clock::now();
+        session.reset();
+        reset = min(reset, seconds(start));
+    }
+    results.push_back({"step/" + name, "cycles/s", cycles / t, true});
+    results.push_back({"reset/" + name, "us", reset * 1e6, false});
+    cerr << "  step " << name << ": " << cycles << " cycles in " << t * 1000.0 << " ms, reset "
+         << reset * 1e6 << " us\n";
+}
+
+// ISA-level execution through the block cache, or the JIT; the first run also pays
+// for translation (and compilation)
+static void benchFunctional(vector<Result>& results, const string& name, const string& source, unsigned repeat,
+                            bool jit) {
+    Session session(assembleProgram(source));
+    RISCV_Simulator& sim = session.simulator();
+
+    uint64_t instructions = 0;
+    double t = 1e300;
+    for (unsigned r = 0; r < repeat; r++) {
+        auto start = chrono::steady_clock::now();
+        instructions = jit ? sim.run_jit() : sim.run_functional();
+        t = min(t, seconds(start));
+        session.reset();
+    }
+    string kind = jit ? "jit" : "functional";
+    results.push_back({kind + "/" + name, "instructions/s", instructions / t, true});
+    cerr << "  " << kind << " " << name << ": " << instructions << " instructions in " << t * 1000.0 << " ms ("
+         << sim.get_translated_blocks() << " blocks, " << sim.get_compiled_blocks() << " compiled)\n";
+}
+
+static void benchInit(vector<Result>& results, const SimulatorConfig& config, unsigned repeat) {
+    string source = assemblerSource(10000);
+    Program program = assembleProgram(source);
+
+    // Building the simulator from an assembled program: predecode, data load, snapshot
+    double load = bestOf(repeat, [&]() { Session session(program, config); });
+    results.push_back({"init/load_10000_lines", "us", load * 1e6, false});
+
+    // What initializeSimulator does from source text
+    double full = bestOf(repeat, [&]() {
+        Session session(assembleProgram(source), config);
+    });
+    results.push_back({"init/assemble_and_load_10000_lines", "us", full * 1e6, false});
+}
+
+// --- JSON ---
+
+static void writeJson(ostream& out, const vector<Result>& results, const SimulatorConfig& config) {
+    out << "{\n  \"config\": \"" << describeSimulatorConfig(config) << "\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\", \"value\": "
+            << setprecision(6) << r.value << ", \"higher_is_better\": " << (r.higher_is_better ? "true" : "false")
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads back the results of writeJson (one result object per line)
+static bool readJson(const string& path, map<string, double>& values) {
+    ifstream in(path);
+    if (!in.is_open()) return false;
+    string line;
+    while (getline(in, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t value = line.find("\"value\": ");
+        if (name == string::npos || value == string::npos) continue;
+        name += 9;
+        values[line.substr(name, line.find('"', name) - name)] = stod(line.substr(value + 9));
+    }
+    return true;
+}
+
+// Prints current against baseline; returns the number of results worse than threshold percent
+static int compare(const vector<Result>& results, const map<string, double>& baseline, double threshold) {
+    int regressions = 0;
+    cout << left << setw(40) << "benchmark" << right << setw(16) << "baseline" << setw(16) << "current"
+         << setw(10) << "change" << "\n";
+    for (const Result& r : results) {
+        auto it = baseline.find(r.name);
+        cout << left << setw(40) << r.name << right << fixed << setprecision(1);
+        if (it == baseline.end() || it->second == 0) {
+            cout << setw(16) << "-" << setw(16) << r.value << setw(10) << "new" << "\n";
+            continue;
+        }
+        // Positive = better, whichever direction the unit improves in
+        double change = (r.value - it->second) / it->second * 100.0;
+        if (!r.higher_is_better) change = -change;
+        bool worse = change < -threshold;
+        if (worse) regressions++;
+        cout << setw(16) << it->second << setw(16) << r.value << setw(9) << showpos << change << noshowpos << "%"
+             << (worse ? "  REGRESSION" : "") << "\n";
+    }
+    cout.unsetf(ios::floatfield);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    unsigned repeat = 5;
+    string jsonPath, baselinePath;
+    double threshold = 10.0;
+    SimulatorConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = max(1u, (unsigned)stoul(argv[++i]));
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = stod(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            string key = arg.substr(2, eq == string::npos ? string::npos : eq - 2);
+            string value = (eq == string::npos) ? "1" : arg.substr(eq + 1);
+            string error;
+            if (!applySimulatorOption(config, key, value, error)) {
+                cerr << "ERROR: " << error << endl;
+                return 1;
+            }
+        } else {
+            cerr << "ERROR: Unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+    string configError;
+    if (!validateSimulatorConfig(config, configError)) {
+        cerr << "ERROR: " << configError << endl;
+        return 1;
+    }
+
+    vector<size_t> sizes = quick ? vector<size_t>{1000, 10000, 100000} : vector<size_t>{1000, 10000, 100000, 1000000};
+    int scale = quick ? 1 : 10;
+
+    vector<Result> results;
+    cerr << fixed << setprecision(3) << "config: " << describeSimulatorConfig(config) << "\n";
+    benchAssembler(results, sizes, quick ? 1 : repeat);
+    benchStep(results, "hazard", hazardProgram(2000 * scale), config, repeat);
+    benchStep(results, "branch", branchProgram(4 * scale), config, repeat);
+    benchStep(results, "memory", memoryProgram(1000 * scale), config, repeat);
+    benchStep(results, "compute", computeProgram(200 * scale), config, repeat);
+    for (bool jit : {false, true}) {
+        benchFunctional(results, "hazard", hazardProgram(2000 * scale), repeat, jit);
+        benchFunctional(results, "branch", branchProgram(4 * scale), repeat, jit);
+        benchFunctional(results, "memory", memoryProgram(1000 * scale), repeat, jit);
+        benchFunctional(results, "compute", computeProgram(200 * scale), repeat, jit);
+    }
+    benchInit(results, config, repeat);
+
+    if (!jsonPath.empty()) {
+        ofstream out(jsonPath);
+        if (!out.is_open()) {
+            cerr << "ERROR: Could not open output file " << jsonPath << endl;
+            return 1;
+        }
+        writeJson(out, results, config);
+    }
+
+    if (baselinePath.empty()) {
+        if (jsonPath.empty()) writeJson(cout, results, config);
+        return 0;
+    }
+    map<string, double> baseline;
+    if (!readJson(baselinePath, baseline)) {
+        cerr << "ERROR: Could not read baseline " << baselinePath << endl;
+        return 1;
+    }
+    int regressions = compare(results, baseline, threshold);
+    if (regressions) {
+        cout << regressions << " result" << (regressions > 1 ? "s" : "") << " worse than the baseline by more than "
+             << fixed << setprecision(1) << threshold << "%\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Measures RISCV_Simulator::step() throughput with tracing off versus on.
+//   trace_bench [blocks]   (default 20000 hazard blocks of 5 instructions)
+#include "../hpp_files/assembler.hpp"
+#include "../hpp_files/parser.hpp"
+#include "../hpp_files/session.hpp"
+#include <chrono>
+
+// Discards everything written to it, so "full" measures formatting cost, not terminal I/O
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static string generateProgram(int blocks) {
+    stringstream src;
+    src << ".data\n";
+    src << "a: .word 7\n";
+    src << "b: .word 9\n";
+    src << ".text\n";
+    for (int i = 0; i < blocks; i++) {
+        src << "lw x1, 0(x0)\n";
+        src << "lw x2, 4(x0)\n";
+        src << "slt x3, x1, x2\n";
+        src << "sll x4, x1, x3\n";
+        src << "sw x4, 8(x0)\n";
+    }
+    return src.str();
+}
+
+static void runCase(const Program& program, const char* name, TraceLevel level, TraceSink* sink) {
+    Session session(program);
+    RISCV_Simulator& sim = session.simulator();
+    sim.set_trace(level, sink);
+
+    uint64_t cycles = 0;
+    auto start = chrono::steady_clock::now();
+    while (!sim.is_halted()) {
+        sim.step();
+        cycles++;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << left << setw(12) << name << right
+         << setw(12) << cycles << " cycles  "
+         << setw(10) << fixed << setprecision(3) << seconds * 1000.0 << " ms  "
+         << setw(14) << setprecision(0) << cycles / seconds << " cycles/s\n";
+}
+
+int main(int argc, char** argv) {
+    int blocks = argc > 1 ? stoi(argv[1]) : 20000;
+
+    Program program = assembleProgram(generateProgram(blocks));
+
+    NullBuffer nullBuffer;
+    ostream nullStream(&nullBuffer);
+    StreamTraceSink nullSink(nullStream);
+
+    cout << "Program: " << program.machine_code.size() << " instructions\n";
+    runCase(program, "off", TraceLevel::Off, nullptr);
+    runCase(program, "summary", TraceLevel::Summary, &nullSink);
+    runCase(program, "structured", TraceLevel::Structured, &nullSink);
+    runCase(program, "full", TraceLevel::Full, &nullSink);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "../hpp_files/block_cache.hpp"
+#include "../hpp_files/alu.hpp"
+
+// --- Handlers (rd is never x0: those writes are dropped at translation) ---
+
+template <uint8_t Funct3, bool Alt>
+static void op_alu(const ThreadedOp& op, int32_t* regs, SparseMemory&) {
+    regs[op.rd] = alu_result(Funct3, Alt, regs[op.rs1], regs[op.rs2]);
+}
+template <uint8_t Funct3, bool Alt>
+static void op_alui(const ThreadedOp& op, int32_t* regs, SparseMemory&) {
+    regs[op.rd] = alu_result(Funct3, Alt, regs[op.rs1], op.imm);
+}
+template <uint8_t Funct3>
+static void op_load(const ThreadedOp& op, int32_t* regs, SparseMemory& mem) {
+    regs[op.rd] = load_value(Funct3, mem, (uint32_t)regs[op.rs1] + (uint32_t)op.imm);
+}
+template <uint8_t Funct3>
+static void op_store(const ThreadedOp& op, int32_t* regs, SparseMemory& mem) {
+    store_value(Funct3, mem, (uint32_t)regs[op.rs1] + (uint32_t)op.imm, (uint32_t)regs[op.rs2]);
+}
+static void op_li(const ThreadedOp& op, int32_t* regs, SparseMemory&) {
+    regs[op.rd] = op.imm;
+}
+template <uint8_t Funct3>
+static void op_muldiv(const ThreadedOp& op, int32_t* regs, SparseMemory&) {
+    regs[op.rd] = muldiv_result(Funct3, regs[op.rs1], regs[op.rs2]);
+}
+
+ThreadedOp translate_op(const ID_EX& c, uint32_t pc) {
+    // By funct3
+    static const OpKind r_kinds[8] = {
+        OpKind::Add, OpKind::Sll, OpKind::Slt, OpKind::Sltu, OpKind::Xor, OpKind::Srl, OpKind::Or, OpKind::And,
+    };
+    static const OpKind i_kinds[8] = {
+        OpKind::Addi, OpKind::Slli, OpKind::Slti, OpKind::Sltiu, OpKind::Xori, OpKind::Srli, OpKind::Ori, OpKind::Andi,
+    };
+    static const OpKind load_kinds[8] = {
+        OpKind::Lb, OpKind::Lh, OpKind::Lw, OpKind::Lw, OpKind::Lbu, OpKind::Lhu, OpKind::Lw, OpKind::Lw,
+    };
+
+    ThreadedOp op = {nullptr, OpKind::None, c.rd, c.rs1, c.rs2, c.IMM};
+
+    if (c.opcode == OP_STORE) {
+        op.kind = c.func3 == 0x0 ? OpKind::Sb : c.func3 == 0x1 ? OpKind::Sh : OpKind::Sw;
+    } else if (!c.RegWrite || c.rd == 0) {
+        return op;
+    } else if (is_muldiv(c)) {
+        op.kind = (OpKind)((uint8_t)OpKind::Mul + c.func3);
+    } else if (c.opcode == OP_R_TYPE) {
+        bool alt = c.func7 == 0x20;
+        if (alt && c.func3 == 0x0)      op.kind = OpKind::Sub;
+        else if (alt && c.func3 == 0x5) op.kind = OpKind::Sra;
+        else                            op.kind = r_kinds[c.func3];
+    } else if (c.opcode == OP_I_TYPE) {
+        op.kind = (c.func7 == 0x20 && c.func3 == 0x5) ? OpKind::Srai : i_kinds[c.func3];
+    } else if (c.opcode == OP_LOAD) {
+        op.kind = load_kinds[c.func3];
+    } else if (c.opcode == OP_LUI) {
+        op.kind = OpKind::Li;
+    } else if (c.opcode == OP_AUIPC) {
+        op.kind = OpKind::Li;
+        op.imm = (int32_t)(pc + (uint32_t)c.IMM);
+    } else {
+        return op;  // Jumps end their block
+    }
+
+    // In OpKind order
+    static const ThreadedOp::Handler handlers[] = {
+        nullptr,
+        op_alu<0, false>, op_alu<0, true>, op_alu<1, false>, op_alu<2, false>, op_alu<3, false>,
+        op_alu<4, false>, op_alu<5, false>, op_alu<5, true>, op_alu<6, false>, op_alu<7, false>,
+        op_alui<0, false>, op_alui<2, false>, op_alui<3, false>, op_alui<4, false>, op_alui<6, false>,
+        op_alui<7, false>, op_alui<1, false>, op_alui<5, false>, op_alui<5, true>,
+        op_load<0>, op_load<1>, op_load<2>, op_load<4>, op_load<5>,
+        op_store<0>, op_store<1>, op_store<2>,
+        op_li,
+        op_muldiv<0>, op_muldiv<1>, op_muldiv<2>, op_muldiv<3>,
+        op_muldiv<4>, op_muldiv<5>, op_muldiv<6>, op_muldiv<7>,
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == (size_t)OpKind::Remu + 1, "one handler per OpKind");
+    op.exec = handlers[(size_t)op.kind];
+    return op;
+}
+
+BranchKind branch_kind(const ID_EX& c) {
+    static const BranchKind kinds[8] = {  // By funct3
+        BranchKind::Eq, BranchKind::Ne, BranchKind::Never, BranchKind::Never,
+        BranchKind::Lt, BranchKind::Ge, BranchKind::Ltu, BranchKind::Geu,
+    };
+    if (c.opcode == OP_JAL) return BranchKind::Jal;
+    if (c.opcode == OP_JALR) return BranchKind::Jalr;
+    if (c.opcode != OP_BRANCH) return BranchKind::None;
+    return kinds[c.func3];
+}
+
+TranslatedBlock* BlockCache::lookup(const std::vector<DecodedInst>& program, uint32_t base, uint32_t pc) {
+    uint32_t idx = (pc - base) >> 2;
+    if ((pc & 0x3) || idx >= program.size() || program[idx].ctrl.IR == 0) return nullptr;
+
+    if (blocks.size() != program.size()) blocks.resize(program.size());
+    if (blocks[idx]) return blocks[idx].get();
+
+    auto block = std::make_unique<TranslatedBlock>();
+    block->start_pc = pc;
+    block->length = 0;
+    block->branch = BranchKind::None;
+    block->rs1 = block->rs2 = block->rd = 0;
+    block->imm = 0;
+    block->taken_pc = 0;
+    block->taken_block = block->next_block = nullptr;
+    block->runs = 0;
+    block->native = nullptr;
+
+    // Straight-line run up to the first branch or jump, the end of the program or an empty slot
+    uint32_t i = idx;
+    for (; i < program.size() && program[i].ctrl.IR != 0; i++) {
+        const ID_EX& c = program[i].ctrl;
+        block->length++;
+        if (c.Branch || c.Jump) {
+            block->branch = branch_kind(c);
+            block->rs1 = c.rs1;
+            block->rs2 = c.rs2;
+            block->rd = c.rd;
+            block->imm = c.IMM;
+            block->taken_pc = c.opcode == OP_JALR ? 0 : base + 4 * i + c.IMM;
+            i++;
+            break;
+        }
+        ThreadedOp op = translate_op(c, base + 4 * i);
+        if (op.exec) block->ops.push_back(op);
+    }
+    block->next_pc = base + 4 * i;
+
+    blocks[idx] = std::move(block);
+    return blocks[idx].get();
+}
+
+size_t BlockCache::size() const {
+    size_t count = 0;
+    for (const auto& block : blocks) count += block != nullptr;
+    return count;
+}
@@ -0,0 +1,105 @@
+#include "../hpp_files/branch_predictor.hpp"
+#include <cstring>
+
+BranchPredictor::BranchPredictor(PredictorKind k, unsigned bht_entries, unsigned btb_entries)
+    : kind(k)
+{
+    std::memset(&stats, 0, sizeof(stats));
+    if (kind == PredictorKind::BHT) bht.assign(bht_entries ? bht_entries : 1, 1);
+    if (kind == PredictorKind::BTB) btb.assign(btb_entries ? btb_entries : 1, BTBEntry{0, 0, 0, false});
+}
+
+BranchPrediction BranchPredictor::predict(uint32_t pc, const DecodedInst& inst) const {
+    BranchPrediction prediction = {false, 0};
+
+    if (kind == PredictorKind::BTB) {
+        // Hits only for branches EX has already seen at this PC
+        const BTBEntry& entry = btb[index(pc, btb.size())];
+        if (entry.valid && entry.tag == pc && entry.counter >= 2) {
+            prediction.taken = true;
+            prediction.target = entry.target;
+        }
+        return prediction;
+    }
+
+    // JAL's target is known at fetch, so every scheme that decodes there takes it.
+    // JALR's depends on a register: only the BTB can predict it.
+    if (inst.ctrl.opcode == OP_JAL && kind != PredictorKind::NotTaken) {
+        prediction.taken = true;
+        prediction.target = pc + inst.ctrl.IMM;
+        return prediction;
+    }
+
+    if (!inst.ctrl.Branch) return prediction;
+    uint32_t target = pc + inst.ctrl.IMM;
+
+    switch (kind) {
+    case PredictorKind::BTFN:
+        prediction.taken = inst.ctrl.IMM < 0;
+        break;
+    case PredictorKind::BHT:
+        prediction.taken = bht[index(pc, bht.size())] >= 2;
+        break;
+    default:
+        break;
+    }
+    prediction.target = target;
+    return prediction;
+}
+
+void BranchPredictor::update(uint32_t pc, bool taken, uint32_t target, bool mispredicted, Undo* undo) {
+    if (undo) {
+        undo->pc = pc;
+        undo->taken = taken;
+        undo->mispredicted = mispredicted;
+        if (kind == PredictorKind::BHT) undo->bht_counter = bht[index(pc, bht.size())];
+        if (kind == PredictorKind::BTB) undo->btb_entry = btb[index(pc, btb.size())];
+    }
+
+    stats.branches++;
+    if (taken) stats.taken++;
+    if (mispredicted) stats.mispredicts++;
+
+    if (kind == PredictorKind::BHT) {
+        uint8_t& counter = bht[index(pc, bht.size())];
+        if (taken && counter < 3) counter++;
+        else if (!taken && counter > 0) counter--;
+    } else if (kind == PredictorKind::BTB) {
+        BTBEntry& entry = btb[index(pc, btb.size())];
+        if (!entry.valid || entry.tag != pc) {
+            if (!taken) return; // Only taken branches allocate
+            entry = BTBEntry{pc, target, 2, true};
+            return;
+        }
+        entry.target = target;
+        if (taken && entry.counter < 3) entry.counter++;
+        else if (!taken && entry.counter > 0) entry.counter--;
+    }
+}
+
+void BranchPredictor::revert(const Undo& undo) {
+    stats.branches--;
+    if (undo.taken) stats.taken--;
+    if (undo.mispredicted) stats.mispredicts--;
+
+    if (kind == PredictorKind::BHT) bht[index(undo.pc, bht.size())] = undo.bht_counter;
+    if (kind == PredictorKind::BTB) btb[index(undo.pc, btb.size())] = undo.btb_entry;
+}
+
+bool parsePredictorKind(const std::string& name, PredictorKind& kind) {
+    if (name == "not-taken")  kind = PredictorKind::NotTaken;
+    else if (name == "btfn")  kind = PredictorKind::BTFN;
+    else if (name == "bht")   kind = PredictorKind::BHT;
+    else if (name == "btb")   kind = PredictorKind::BTB;
+    else return false;
+    return true;
+}
+
+const char* predictorKindName(PredictorKind kind) {
+    switch (kind) {
+    case PredictorKind::BTFN: return "btfn";
+    case PredictorKind::BHT:  return "bht";
+    case PredictorKind::BTB:  return "btb";
+    default:                  return "not-taken";
+    }
+}
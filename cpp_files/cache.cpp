@@ -0,0 +1,146 @@
+#include "../hpp_files/cache.hpp"
+
+static unsigned log2u(unsigned n) {
+    unsigned bits = 0;
+    while ((1u << bits) < n) bits++;
+    return bits;
+}
+
+Cache::Cache(const CacheConfig& cfg) : config(cfg), tick(0), rng(0x9E3779B9u), stats() {
+    if (!config.enabled || !validateCacheConfig(config).empty()) {
+        config.enabled = false;
+        sets = 0;
+        offset_bits = 0;
+        index_bits = 0;
+        return;
+    }
+    sets = config.size / (config.ways * config.line_size);
+    offset_bits = log2u(config.line_size);
+    index_bits = log2u(sets);
+    lines.assign((size_t)sets * config.ways, Line());
+}
+
+unsigned Cache::choose_victim(Line* set) {
+    for (unsigned w = 0; w < config.ways; w++) {
+        if (!set[w].valid) return w;
+    }
+    if (config.policy == ReplacementPolicy::Random) {
+        rng ^= rng << 13;  // xorshift32
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng % config.ways;
+    }
+    unsigned victim = 0;  // LRU and FIFO both evict the oldest stamp
+    for (unsigned w = 1; w < config.ways; w++) {
+        if (set[w].stamp < set[victim].stamp) victim = w;
+    }
+    return victim;
+}
+
+unsigned Cache::access(uint32_t addr, bool write, Undo* undo) {
+    if (undo) undo->events = 0;
+    if (!config.enabled) return 1;
+
+    tick++;
+    if (write) stats.writes++;
+    else stats.reads++;
+
+    uint32_t index = (addr >> offset_bits) & (sets - 1);
+    uint32_t tag = addr >> (offset_bits + index_bits);
+    Line* set = &lines[(size_t)index * config.ways];
+
+    if (undo) {
+        undo->events = Undo::ACCESSED | (write ? Undo::WRITE : 0);
+        undo->line = -1;
+        undo->rng = rng;
+    }
+
+    for (unsigned w = 0; w < config.ways; w++) {
+        if (set[w].valid && set[w].tag == tag) {
+            stats.hits++;
+            if (undo) {
+                undo->events |= Undo::HIT;
+                undo->line = (int32_t)(index * config.ways + w);
+                undo->old = set[w];
+            }
+            if (config.policy == ReplacementPolicy::LRU) set[w].stamp = tick;
+            if (!write) return config.hit_latency;
+            if (config.write_back) {
+                set[w].dirty = true;
+                return config.hit_latency;
+            }
+            return config.hit_latency + config.miss_latency;  // Write-through: the word goes to memory too
+        }
+    }
+
+    stats.misses++;
+    if (write && !config.write_back) {
+        return config.hit_latency + config.miss_latency;  // No write-allocate: memory write only
+    }
+
+    unsigned cycles = config.hit_latency + config.miss_latency;
+    unsigned way = choose_victim(set);
+    Line& victim = set[way];
+    if (undo) {
+        undo->line = (int32_t)(index * config.ways + way);
+        undo->old = victim;
+    }
+    if (victim.valid) {
+        stats.evictions++;
+        if (undo) undo->events |= Undo::EVICTION;
+        if (victim.dirty) {
+            stats.writebacks++;
+            if (undo) undo->events |= Undo::WRITEBACK;
+            cycles += config.miss_latency;
+        }
+    }
+    victim.tag = tag;
+    victim.stamp = tick;
+    victim.valid = true;
+    victim.dirty = write;
+    return cycles;
+}
+
+void Cache::revert(const Undo& undo) {
+    if (!(undo.events & Undo::ACCESSED)) return;
+
+    tick--;
+    rng = undo.rng;
+    if (undo.events & Undo::WRITE) stats.writes--;
+    else stats.reads--;
+    if (undo.events & Undo::HIT) stats.hits--;
+    else stats.misses--;
+    if (undo.events & Undo::EVICTION) stats.evictions--;
+    if (undo.events & Undo::WRITEBACK) stats.writebacks--;
+    if (undo.line >= 0) lines[undo.line] = undo.old;
+}
+
+bool parseReplacementPolicy(const std::string& name, ReplacementPolicy& policy) {
+    if (name == "lru")         policy = ReplacementPolicy::LRU;
+    else if (name == "fifo")   policy = ReplacementPolicy::FIFO;
+    else if (name == "random") policy = ReplacementPolicy::Random;
+    else return false;
+    return true;
+}
+
+const char* replacementPolicyName(ReplacementPolicy policy) {
+    switch (policy) {
+    case ReplacementPolicy::LRU:    return "lru";
+    case ReplacementPolicy::FIFO:   return "fifo";
+    case ReplacementPolicy::Random: return "random";
+    }
+    return "lru";
+}
+
+std::string validateCacheConfig(const CacheConfig& config) {
+    auto pow2 = [](unsigned n) { return n != 0 && (n & (n - 1)) == 0; };
+    if (!pow2(config.size) || !pow2(config.ways) || !pow2(config.line_size)) {
+        return "cache size, ways and line size must be powers of two";
+    }
+    if (config.line_size < 4) return "cache line size must be at least 4 bytes";
+    if ((unsigned long long)config.ways * config.line_size > config.size) {
+        return "cache size must hold at least one set (ways * line size)";
+    }
+    if (config.hit_latency == 0) return "cache hit latency must be at least 1 cycle";
+    return "";
+}
@@ -0,0 +1,64 @@
+#include "../hpp_files/decoder.hpp"
+#include <cstring>
+
+int32_t sign_extend_imm(uint32_t inst, int type) {
+    int32_t value = 0;
+    if (type == 0) { // I-type: imm[11:0] = inst[31:20]
+        value = (int32_t)inst >> 20;
+    } else if (type == 1) { // S-type: imm[11:5] = inst[31:25], imm[4:0] = inst[11:7]
+        value = (((int32_t)inst >> 25) << 5) | ((inst >> 7) & 0x1F);
+    } else if (type == 2) { // B-type: imm[12|10:5] = inst[31:25], imm[4:1|11] = inst[11:7]
+        value = (((int32_t)inst >> 31) << 12)   // imm[12] (sign)
+              | (((inst >> 7) & 0x1) << 11)     // imm[11]
+              | (((inst >> 25) & 0x3F) << 5)    // imm[10:5]
+              | (((inst >> 8) & 0xF) << 1);     // imm[4:1]
+    } else if (type == 3) { // U-type: imm[31:12] = inst[31:12]
+        value = (int32_t)(inst & 0xFFFFF000);
+    } else if (type == 4) { // J-type: imm[20|10:1|11|19:12] = inst[31:12]
+        value = (((int32_t)inst >> 31) << 20)   // imm[20] (sign)
+              | (inst & 0xFF000)                // imm[19:12]
+              | (((inst >> 20) & 0x1) << 11)    // imm[11]
+              | (((inst >> 21) & 0x3FF) << 1);  // imm[10:1]
+    }
+    return value;
+}
+
+DecodedInst decode_instruction(uint32_t inst) {
+    DecodedInst d;
+    std::memset(&d, 0, sizeof(d));
+
+    ID_EX& c = d.ctrl;
+    c.IR     = inst;
+    c.opcode = inst & 0x7F;
+    c.rd     = (inst >> 7) & 0x1F;
+    c.func3  = (inst >> 12) & 0x07;
+    c.rs1    = (inst >> 15) & 0x1F;
+    c.rs2    = (inst >> 20) & 0x1F;
+    c.func7  = (inst >> 25) & 0x7F;
+
+    // Control signals
+    c.RegWrite = (c.opcode == OP_R_TYPE || c.opcode == OP_I_TYPE || c.opcode == OP_LOAD ||
+                  c.opcode == OP_LUI || c.opcode == OP_AUIPC || c.opcode == OP_JAL || c.opcode == OP_JALR);
+    c.MemRead  = (c.opcode == OP_LOAD);
+    c.MemWrite = (c.opcode == OP_STORE);
+    c.Branch   = (c.opcode == OP_BRANCH);
+    c.Jump     = (c.opcode == OP_JAL || c.opcode == OP_JALR);
+
+    // Sign extended immediate
+    if (c.opcode == OP_I_TYPE || c.opcode == OP_LOAD || c.opcode == OP_JALR) {
+        c.IMM = sign_extend_imm(inst, 0);
+    } else if (c.opcode == OP_STORE) {
+        c.IMM = sign_extend_imm(inst, 1);
+    } else if (c.opcode == OP_BRANCH) {
+        c.IMM = sign_extend_imm(inst, 2);
+    } else if (c.opcode == OP_LUI || c.opcode == OP_AUIPC) {
+        c.IMM = sign_extend_imm(inst, 3);
+    } else if (c.opcode == OP_JAL) {
+        c.IMM = sign_extend_imm(inst, 4);
+    }
+
+    d.needs_rs1 = (c.opcode == OP_R_TYPE || c.opcode == OP_I_TYPE || c.opcode == OP_LOAD ||
+                   c.opcode == OP_STORE || c.opcode == OP_BRANCH || c.opcode == OP_JALR);
+    d.needs_rs2 = (c.opcode == OP_R_TYPE || c.opcode == OP_STORE || c.opcode == OP_BRANCH);
+    return d;
+}
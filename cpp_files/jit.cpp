@@ -0,0 +1,301 @@
+#include "../hpp_files/jit.hpp"
+#include "../hpp_files/alu.hpp"
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_X86_64 1
+#endif
+
+#ifdef JIT_X86_64
+
+// Called from generated code (System V ABI)
+template <uint8_t Funct3>
+static int32_t jit_load(SparseMemory* mem, uint32_t addr) {  // Extended to 32 bits here
+    return load_value(Funct3, *mem, addr);
+}
+template <uint8_t Funct3>
+static void jit_store(SparseMemory* mem, uint32_t addr, uint32_t value) {
+    store_value(Funct3, *mem, addr, value);
+}
+template <uint8_t Funct3>
+static int32_t jit_divide(int32_t a, int32_t b) {  // The divide-by-zero and overflow cases stay in C++
+    return muldiv_result(Funct3, a, b);
+}
+
+namespace {
+
+// Just the encodings the block compiler needs. Guest register r lives at
+// [rbx + 4*r]; every disp fits in a signed byte.
+struct Emitter {
+    std::vector<uint8_t> out;
+
+    void byte(uint8_t b) { out.push_back(b); }
+    void bytes(std::initializer_list<uint8_t> bs) { out.insert(out.end(), bs); }
+    void imm32(uint32_t v) { for (int i = 0; i < 4; i++) byte((uint8_t)(v >> (8 * i))); }
+    void imm64(uint64_t v) { for (int i = 0; i < 8; i++) byte((uint8_t)(v >> (8 * i))); }
+
+    // op reg32, [rbx + 4*guest] (and the store direction for 0x89); reg: 0=eax 1=ecx 2=edx 6=esi 7=edi
+    void regMem(uint8_t opcode, uint8_t reg, uint8_t guest) {
+        bytes({opcode, (uint8_t)(0x40 | (reg << 3) | 3), (uint8_t)(4 * guest)});
+    }
+    void load(uint8_t reg, uint8_t guest)  { regMem(0x8B, reg, guest); }  // mov reg, [guest]
+    void store(uint8_t reg, uint8_t guest) { regMem(0x89, reg, guest); }  // mov [guest], reg
+
+    void call(const void* fn) {
+        bytes({0x48, 0xB8}); imm64((uint64_t)fn);         // mov rax, fn
+        bytes({0xFF, 0xD0});                              // call rax
+    }
+    void callMemory(const void* fn) {
+        bytes({0x4C, 0x89, 0xE7});                        // mov rdi, r12
+        call(fn);
+    }
+    // rax = guest rs1 * guest rs2 as 64 bits, each operand sign- or zero-extended
+    void multiply64(uint8_t rs1, bool signed1, uint8_t rs2, bool signed2) {
+        if (signed1) byte(0x48);
+        regMem(signed1 ? 0x63 : 0x8B, 0, rs1);            // movsxd rax, [rs1] / mov eax, [rs1]
+        if (signed2) byte(0x48);
+        regMem(signed2 ? 0x63 : 0x8B, 1, rs2);            // movsxd rcx, [rs2] / mov ecx, [rs2]
+        bytes({0x48, 0x0F, 0xAF, 0xC1});                  // imul rax, rcx (the low 64 bits are exact)
+    }
+    // esi = guest rs1 + imm (the effective address)
+    void address(uint8_t rs1, int32_t imm) {
+        load(6, rs1);
+        bytes({0x81, 0xC6}); imm32((uint32_t)imm);        // add esi, imm
+    }
+};
+
+const uint8_t EAX = 0, ECX = 1, EDX = 2, ESI = 6, EDI = 7;
+
+// x86 condition code (the low nibble of Jcc/SETcc/CMOVcc) of `cmp rs1, rs2` for a
+// taken branch, or 0xFF for block ends that are not conditional
+uint8_t conditionCode(BranchKind kind) {
+    switch (kind) {
+    case BranchKind::Eq:  return 0x4;   // e
+    case BranchKind::Ne:  return 0x5;   // ne
+    case BranchKind::Lt:  return 0xC;   // l
+    case BranchKind::Ge:  return 0xD;   // ge
+    case BranchKind::Ltu: return 0x2;   // b
+    case BranchKind::Geu: return 0x3;   // ae
+    default:              return 0xFF;
+    }
+}
+
+// rd = (rs1 <cc> op2) ? 1 : 0 for the SLT family, op2 being [rs2] or an immediate
+void emitSet(Emitter& e, const ThreadedOp& op, uint8_t cc, bool immediate) {
+    e.bytes({0x31, 0xC9});                                // xor ecx, ecx (before the cmp: it clobbers flags)
+    e.load(EAX, op.rs1);
+    if (immediate) { e.byte(0x3D); e.imm32((uint32_t)op.imm); }  // cmp eax, imm
+    else e.regMem(0x3B, EAX, op.rs2);                     // cmp eax, [rs2]
+    e.bytes({0x0F, (uint8_t)(0x90 | cc), 0xC1});          // setcc cl
+    e.store(ECX, op.rd);
+}
+
+void emitOp(Emitter& e, const ThreadedOp& op) {
+    // By OpKind, relative to the first of each group
+    static const void* const loads[5] = {
+        (const void*)jit_load<0>, (const void*)jit_load<1>, (const void*)jit_load<2>, (const void*)jit_load<4>, (const void*)jit_load<5>,
+    };
+    static const void* const stores[3] = {
+        (const void*)jit_store<0>, (const void*)jit_store<1>, (const void*)jit_store<2>,
+    };
+
+    switch (op.kind) {
+    case OpKind::Add:
+    case OpKind::Sub:
+    case OpKind::Xor:
+    case OpKind::Or:
+    case OpKind::And: {
+        uint8_t opcode = op.kind == OpKind::Add ? 0x03 : op.kind == OpKind::Sub ? 0x2B
+                       : op.kind == OpKind::Xor ? 0x33 : op.kind == OpKind::Or ? 0x0B : 0x23;
+        e.load(EAX, op.rs1); e.regMem(opcode, EAX, op.rs2); e.store(EAX, op.rd);  // add/sub/xor/or/and eax, [rs2]
+        break;
+    }
+    case OpKind::Sll:
+    case OpKind::Srl:
+    case OpKind::Sra:
+        e.load(EAX, op.rs1); e.load(ECX, op.rs2);
+        e.bytes({0xD3, (uint8_t)(op.kind == OpKind::Sll ? 0xE0 : op.kind == OpKind::Srl ? 0xE8 : 0xF8)});
+        e.store(EAX, op.rd);                              // shl/shr/sar eax, cl (the count is masked to 5 bits)
+        break;
+    case OpKind::Slt:   emitSet(e, op, 0xC, false); break;  // setl
+    case OpKind::Sltu:  emitSet(e, op, 0x2, false); break;  // setb
+    case OpKind::Slti:  emitSet(e, op, 0xC, true); break;
+    case OpKind::Sltiu: emitSet(e, op, 0x2, true); break;
+    case OpKind::Addi:
+    case OpKind::Xori:
+    case OpKind::Ori:
+    case OpKind::Andi:
+        e.load(EAX, op.rs1);
+        e.byte(op.kind == OpKind::Addi ? 0x05 : op.kind == OpKind::Xori ? 0x35 : op.kind == OpKind::Ori ? 0x0D : 0x25);
+        e.imm32((uint32_t)op.imm);                        // add/xor/or/and eax, imm
+        e.store(EAX, op.rd);
+        break;
+    case OpKind::Slli:
+    case OpKind::Srli:
+    case OpKind::Srai:
+        e.load(EAX, op.rs1);
+        e.bytes({0xC1, (uint8_t)(op.kind == OpKind::Slli ? 0xE0 : op.kind == OpKind::Srli ? 0xE8 : 0xF8),
+                 (uint8_t)(op.imm & 0x1F)});              // shl/shr/sar eax, shamt
+        e.store(EAX, op.rd);
+        break;
+    case OpKind::Lb:
+    case OpKind::Lh:
+    case OpKind::Lw:
+    case OpKind::Lbu:
+    case OpKind::Lhu:
+        e.address(op.rs1, op.imm);
+        e.callMemory(loads[(size_t)op.kind - (size_t)OpKind::Lb]);
+        e.store(EAX, op.rd);
+        break;
+    case OpKind::Sb:
+    case OpKind::Sh:
+    case OpKind::Sw:
+        e.address(op.rs1, op.imm);
+        e.load(EDX, op.rs2);
+        e.callMemory(stores[(size_t)op.kind - (size_t)OpKind::Sb]);
+        break;
+    case OpKind::Li:
+        e.bytes({0xC7, 0x43, (uint8_t)(4 * op.rd)}); e.imm32((uint32_t)op.imm);  // mov dword [rd], imm
+        break;
+    case OpKind::Mul:
+        e.load(EAX, op.rs1);
+        e.byte(0x0F); e.regMem(0xAF, EAX, op.rs2);        // imul eax, [rs2]
+        e.store(EAX, op.rd);
+        break;
+    case OpKind::Mulh:
+    case OpKind::Mulhsu:
+    case OpKind::Mulhu:
+        e.multiply64(op.rs1, op.kind != OpKind::Mulhu, op.rs2, op.kind == OpKind::Mulh);
+        e.bytes({0x48, 0xC1, 0xE8, 0x20});                // shr rax, 32
+        e.store(EAX, op.rd);
+        break;
+    case OpKind::Div:
+    case OpKind::Divu:
+    case OpKind::Rem:
+    case OpKind::Remu: {
+        static const void* const divide[4] = {
+            (const void*)jit_divide<4>, (const void*)jit_divide<5>, (const void*)jit_divide<6>, (const void*)jit_divide<7>,
+        };
+        e.load(EDI, op.rs1); e.load(ESI, op.rs2);
+        e.call(divide[(size_t)op.kind - (size_t)OpKind::Div]);
+        e.store(EAX, op.rd);
+        break;
+    }
+    case OpKind::None:
+        break;
+    }
+}
+
+// Points the jump displacement at `at` to `target`
+void patchRel32(Emitter& e, size_t at, size_t target) {
+    uint32_t rel = (uint32_t)((int64_t)target - (int64_t)(at + 4));
+    std::memcpy(&e.out[at], &rel, 4);
+}
+
+// uint32_t block(int32_t* regs, SparseMemory* mem, uint64_t* iterations)
+std::vector<uint8_t> compileBlock(const TranslatedBlock& block) {
+    uint8_t cc = conditionCode(block.branch);
+    bool conditional = cc != 0xFF;
+    bool selfLoop = conditional && block.taken_pc == block.start_pc;
+
+    Emitter e;
+    e.bytes({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x55});  // push rbx, r12, r13, r14, rbp (stack 16-aligned for calls)
+    e.bytes({0x48, 0x89, 0xFB});                          // mov rbx, rdi   (guest registers)
+    e.bytes({0x49, 0x89, 0xF4});                          // mov r12, rsi   (memory)
+    e.bytes({0x4C, 0x8B, 0x2A});                          // mov r13, [rdx] (iterations left)
+    e.bytes({0x49, 0x89, 0xD6});                          // mov r14, rdx
+
+    size_t top = e.out.size();
+    for (const ThreadedOp& op : block.ops) emitOp(e, op);
+    e.bytes({0x49, 0xFF, 0xCD});                          // dec r13
+
+    if (selfLoop) {
+        // Taken: go round again while iterations are left; not taken: fall through
+        e.load(ECX, block.rs1); e.regMem(0x3B, ECX, block.rs2);                 // cmp ecx, [rs2]
+        e.bytes({0x0F, (uint8_t)(0x80 | (cc ^ 1))});      // j<not cc> fall
+        size_t toFall = e.out.size(); e.imm32(0);
+        e.bytes({0x4D, 0x85, 0xED});                      // test r13, r13
+        e.bytes({0x0F, 0x85}); e.imm32(0); patchRel32(e, e.out.size() - 4, top);  // jnz top
+        e.byte(0xB8); e.imm32(block.taken_pc);            // mov eax, taken_pc
+        e.byte(0xE9); size_t toDone = e.out.size(); e.imm32(0);                   // jmp done
+        patchRel32(e, toFall, e.out.size());
+        e.byte(0xB8); e.imm32(block.next_pc);             // fall: mov eax, next_pc
+        patchRel32(e, toDone, e.out.size());
+    } else if (block.branch == BranchKind::Jal || block.branch == BranchKind::Jalr) {
+        if (block.branch == BranchKind::Jal) {
+            e.byte(0xB8); e.imm32(block.taken_pc);        // mov eax, taken_pc
+        } else {
+            e.load(EAX, block.rs1);                       // Read before the link is written
+            e.byte(0x05); e.imm32((uint32_t)block.imm);   // add eax, imm
+            e.bytes({0x83, 0xE0, 0xFE});                  // and eax, ~1
+        }
+        if (block.rd != 0) {
+            e.bytes({0xC7, 0x43, (uint8_t)(4 * block.rd)}); e.imm32(block.next_pc);  // mov dword [rd], next_pc
+        }
+    } else {
+        e.byte(0xB8); e.imm32(block.next_pc);             // mov eax, next_pc
+        if (conditional) {
+            e.byte(0xBA); e.imm32(block.taken_pc);        // mov edx, taken_pc
+            e.load(ECX, block.rs1); e.regMem(0x3B, ECX, block.rs2);             // cmp ecx, [rs2]
+            e.bytes({0x0F, (uint8_t)(0x40 | cc), 0xC2});  // cmov<cc> eax, edx
+        }
+    }
+
+    e.bytes({0x4D, 0x89, 0x2E});                          // done: mov [r14], r13
+    e.bytes({0x5D, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});  // pop rbp, r14, r13, r12, rbx; ret
+    return e.out;
+}
+
+}  // namespace
+
+bool JitCache::supported() { return true; }
+
+JitCache::~JitCache() {
+    if (code) munmap(code, CODE_BYTES);
+}
+
+NativeBlock JitCache::compile(const TranslatedBlock& block) {
+    if (unavailable) return nullptr;
+    if (!code) {
+        void* mapped = mmap(nullptr, CODE_BYTES, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED) {
+            unavailable = true;
+            return nullptr;
+        }
+        code = (uint8_t*)mapped;
+    }
+
+    std::vector<uint8_t> bytes = compileBlock(block);
+    if (used + bytes.size() > CODE_BYTES) return nullptr;  // Full: the rest stays interpreted
+
+    // Writable only while the block is copied in
+    if (mprotect(code, CODE_BYTES, PROT_READ | PROT_WRITE) != 0) {
+        unavailable = true;
+        return nullptr;
+    }
+    uint8_t* entry = code + used;
+    std::memcpy(entry, bytes.data(), bytes.size());
+    if (mprotect(code, CODE_BYTES, PROT_READ | PROT_EXEC) != 0) {
+        unavailable = true;
+        return nullptr;
+    }
+    used += (bytes.size() + 15) & ~(size_t)15;
+    blocks++;
+    return (NativeBlock)(void*)entry;
+}
+
+void JitCache::clear() {
+    used = 0;
+    blocks = 0;
+}
+
+#else
+
+bool JitCache::supported() { return false; }
+JitCache::~JitCache() {}
+NativeBlock JitCache::compile(const TranslatedBlock&) { return nullptr; }
+void JitCache::clear() { blocks = 0; }
+
+#endif
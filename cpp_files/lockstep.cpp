@@ -0,0 +1,117 @@
+#include "../hpp_files/lockstep.hpp"
+#include <sstream>
+
+static bool compareRegisters(const RISCV_Simulator& a, const RISCV_Simulator& b, std::ostream& diff,
+                             const char* a_name = "pipeline", const char* b_name = "functional") {
+    for (int i = 0; i < 32; i++) {
+        if (a.get_reg(i) != b.get_reg(i)) {
+            diff << "x" << i << ": " << a_name << "=" << a.get_reg(i) << " " << b_name << "=" << b.get_reg(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool compareMemory(const RISCV_Simulator& a, const RISCV_Simulator& b, std::ostream& diff,
+                          const char* a_name = "pipeline", const char* b_name = "functional") {
+    uint32_t addr = 0;
+    if (a.get_memory().equals(b.get_memory(), &addr)) return true;
+    diff << "mem[0x" << std::hex << addr << std::dec << "]: " << a_name << "=" << (int)a.get_mem(addr)
+         << " " << b_name << "=" << (int)b.get_mem(addr);
+    return false;
+}
+
+LockstepResult run_lockstep(RISCV_Simulator& pipeline, RISCV_Simulator& reference, uint64_t max_cycles) {
+    LockstepResult result = {false, false, 0, 0, ""};
+    std::ostringstream diff;
+
+    while (!pipeline.is_halted()) {
+        if (max_cycles != 0 && result.cycles >= max_cycles) return result;
+
+        uint32_t retiring_ir = pipeline.get_mem_wb().IR;
+        uint64_t retired_before = pipeline.get_retired();
+        pipeline.step();
+        result.cycles++;
+        if (pipeline.get_retired() == retired_before) continue;
+
+        uint32_t reference_pc = reference.get_pc();
+        uint32_t reference_ir = reference.get_instruction(reference_pc);
+        if (reference_ir != retiring_ir || !reference.step_functional()) {
+            diff << "cycle " << result.cycles << ": pipeline retired IR=0x" << std::hex << retiring_ir
+                 << " but the functional model executed IR=0x" << reference_ir
+                 << " at PC=0x" << reference_pc << std::dec;
+            result.mismatch = diff.str();
+            return result;
+        }
+        result.retired++;
+
+        diff << "cycle " << result.cycles << ", retirement " << result.retired << ": ";
+        if (!compareRegisters(pipeline, reference, diff)) {
+            result.mismatch = diff.str();
+            return result;
+        }
+
+        // A store that has done MEM but not yet retired is already visible in the
+        // pipeline's memory; compare memory once it has retired too.
+        bool store_in_flight = (pipeline.get_mem_wb().IR & 0x7F) == OP_STORE;
+        if (!store_in_flight && !compareMemory(pipeline, reference, diff)) {
+            result.mismatch = diff.str();
+            return result;
+        }
+        diff.str("");
+    }
+
+    result.halted = true;
+    diff << "after halt: ";
+    if (!reference.is_halted()) {
+        diff << "pipeline halted after " << result.retired << " instructions but the functional model has not";
+        result.mismatch = diff.str();
+        return result;
+    }
+    if (!compareRegisters(pipeline, reference, diff) || !compareMemory(pipeline, reference, diff)) {
+        result.mismatch = diff.str();
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
+
+JitCheckResult run_jit_check(RISCV_Simulator& jit, RISCV_Simulator& reference, uint64_t interval,
+                             uint64_t max_instructions) {
+    JitCheckResult result = {false, false, 0, ""};
+    std::ostringstream diff;
+    if (interval == 0) interval = 1;
+
+    while (max_instructions == 0 || result.retired < max_instructions) {
+        uint64_t chunk = interval;
+        if (max_instructions != 0 && max_instructions - result.retired < chunk) chunk = max_instructions - result.retired;
+
+        uint32_t start_pc = jit.get_pc();
+        uint64_t ran = jit.run_jit(chunk);
+        uint64_t stepped = 0;
+        while (stepped < chunk && reference.step_functional()) stepped++;
+
+        diff << "instructions " << result.retired + 1 << ".." << result.retired + chunk
+             << " (from PC=0x" << std::hex << start_pc << std::dec << "): ";
+        if (ran != stepped) {
+            diff << "jit retired " << ran << " but the interpreter " << stepped;
+        } else if (jit.get_pc() != reference.get_pc()) {
+            diff << "pc: jit=0x" << std::hex << jit.get_pc() << " interpreter=0x" << reference.get_pc() << std::dec;
+        } else if (compareRegisters(jit, reference, diff, "jit", "interpreter") &&
+                   compareMemory(jit, reference, diff, "jit", "interpreter")) {
+            result.retired += ran;
+            diff.str("");
+            if (ran < chunk) {
+                result.halted = true;
+                result.ok = true;
+                return result;
+            }
+            continue;
+        }
+        result.retired += std::min(ran, stepped);
+        result.mismatch = diff.str();
+        return result;
+    }
+    result.ok = true;
+    return result;
+}
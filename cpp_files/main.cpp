@@ -1,16 +1,23 @@
 #include "../hpp_files/assembler.hpp"
 #include "../hpp_files/parser.hpp"
-#include "../hpp_files/encoder.hpp"
-#include "../hpp_files/simulator.hpp"
+#include "../hpp_files/session.hpp"
+#include "../hpp_files/step_batch.hpp"
 #include <emscripten/emscripten.h>
 #include <emscripten/bind.h>
+#include <emscripten/val.h>
 #include <sstream>
 
 using namespace emscripten;
 
-// Global simulator instance
-RISCV_Simulator* globalSim = nullptr;
-vector<ParsedInstruction> globalInstructions;
+// The module's one session: the page works on a single program at a time
+Session* session = nullptr;
+SimulatorConfig globalConfig;   // Options used by initialize and reset
+TraceLevel traceLevel = TraceLevel::Full;  // Console trace for single steps and runCycles (setTraceLevel)
+std::map<int, RISCV_Simulator::Snapshot> checkpoints;  // saveCheckpoint() id -> state
+int nextCheckpointId = 1;
+std::vector<uint32_t> batchBuffer;   // Backs the view returned by stepN
+LatchWords latchWords;               // Backs getLatchView; refreshed after every state change
+std::map<uint32_t, std::unique_ptr<uint8_t[]>> pageViews;  // Page number -> copy backing getMemoryPageView, refreshed likewise
 bool isInitialized = false;
 
 // Structure to hold pipeline state for JS
@@ -41,208 +48,350 @@ struct PipelineStateJS {
     bool mem_wb_regwrite;
 };
 
+// Branch predictor statistics for JS (counts as doubles: embind has no uint64_t)
+struct PredictorStatsJS {
+    double branches;
+    double taken;
+    double mispredicts;
+    double accuracy;
+};
+
+// L1 cache statistics for JS (doubles, as above)
+struct CacheStatsJS {
+    bool enabled;
+    double reads;
+    double writes;
+    double hits;
+    double misses;
+    double evictions;
+    double writebacks;
+    double hit_rate;
+    double stall_cycles;
+};
+
+// Performance counters for JS (doubles for the same reason)
+struct PerfCountersJS {
+    double cycles;
+    double instret;
+    double raw_stalls_ex;
+    double raw_stalls_mem;
+    double raw_stalls_wb;
+    double control_flushes;
+    double bubbles;
+    double loads;
+    double stores;
+    double branches;
+    double muldiv;
+    double ex_busy_stalls;
+    double icache_stall_cycles;
+    double dcache_stall_cycles;
+    double cpi;
+    double ipc;
+};
+
+// Copies one page of simulator memory (zeros if it was never written) into its view buffer
+static void refreshPageView(uint32_t pageNumber, uint8_t* buffer) {
+    const uint8_t* page = session ? session->simulator().memory_page(pageNumber * SparseMemory::PAGE_SIZE) : nullptr;
+    if (page) memcpy(buffer, page, SparseMemory::PAGE_SIZE);
+    else memset(buffer, 0, SparseMemory::PAGE_SIZE);
+}
+
+// Copies the current latches into latchWords and memory into the page views
+// (called by everything that moves the simulator or writes its memory)
+static void refreshViews() {
+    if (session == nullptr) memset(&latchWords, 0, sizeof(latchWords));
+    else session->simulator().get_latch_words(latchWords);
+    for (auto& view : pageViews) refreshPageView(view.first, view.second.get());
+}
+
 // Initialize the simulator with assembly code
 std::string initializeSimulator(std::string assemblyCode) {
     try {
-        // Clean up existing simulator
-        if (globalSim != nullptr) {
-            delete globalSim;
-            globalSim = nullptr;
+        // Clean up existing session
+        if (session != nullptr) {
+            delete session;
+            session = nullptr;
         }
+        isInitialized = false;
+        refreshViews();
+        checkpoints.clear();
         
-        // Clear global state
-        INSTRUCTION_MEMORY.clear();
-        SYMBOL_TABLE.clear();
-        DATA_SEGMENT.clear();
-        globalInstructions.clear();
-        
-        // Write assembly to temporary processing
-        std::istringstream stream(assemblyCode);
-        vector<string> lines;
-        string line;
-        
-        while (getline(stream, line)) {
-            // Remove comments
-            size_t commentPos = line.find('#');
-            if (commentPos != string::npos) {
-                line = line.substr(0, commentPos);
-            }
-            
-            // Trim whitespace
-            line.erase(0, line.find_first_not_of(" \t\r\n"));
-            line.erase(line.find_last_not_of(" \t\r\n") + 1);
-            
-            if (!line.empty()) {
-                lines.push_back(line);
-            }
-        }
-        
-        if (lines.empty()) {
+        // Assemble the editor contents, then load the data segment into a fresh simulator
+        Program program = assembleProgram(std::move(assemblyCode));
+        if (program.instructions.empty() && program.data.empty()) {
             return "ERROR: No valid assembly code provided";
         }
-        
-        // Build symbol table and parse
-        SYMBOL_TABLE = buildSymbolTable(lines);
-        parseDataSection(lines);
-        globalInstructions = parseInstructions(lines);
-        
-        // Translate to opcodes
-        INSTRUCTION_MEMORY = translateToOpcode(globalInstructions);
-        
-        // Create simulator
-        globalSim = new RISCV_Simulator(INSTRUCTION_MEMORY);
-        
-        // Load data segment
-        if (!DATA_SEGMENT.empty()) {
-            for (auto const& [addr, val] : DATA_SEGMENT) {
-                globalSim->set_memory(addr,     val & 0xFF);
-                globalSim->set_memory(addr + 1, (val >> 8) & 0xFF);
-                globalSim->set_memory(addr + 2, (val >> 16) & 0xFF);
-                globalSim->set_memory(addr + 3, (val >> 24) & 0xFF);
-            }
-        }
+        session = new Session(std::move(program), globalConfig);
+        session->simulator().set_trace(traceLevel);
+        session->simulator().enable_history(); // For stepBack / seekToCycle
+        refreshViews();
         
         isInitialized = true;
-        return "SUCCESS: Simulator initialized with " + std::to_string(globalInstructions.size()) + " instructions";
+        return "SUCCESS: Simulator initialized with " + std::to_string(session->get_program().instructions.size()) + " instructions";
         
     } catch (const std::exception& e) {
         return std::string("ERROR: ") + e.what();
     }
 }
 
+// Initialize with pipeline options, e.g. "forwarding=1" (see sim_config.hpp).
+// The options stay in effect for later resets and plain initializeSimulator() calls.
+std::string initializeSimulatorWithOptions(std::string assemblyCode, std::string options) {
+    SimulatorConfig config;
+    std::string error;
+    if (!parseSimulatorOptions(options, config, error)) {
+        return "ERROR: " + error;
+    }
+    globalConfig = config;
+    return initializeSimulator(assemblyCode);
+}
+
+// Current pipeline options as "key=value,..."
+std::string getSimulatorOptions() {
+    return describeSimulatorConfig(globalConfig);
+}
+
+// Console trace level: "off", "summary", "full" (the default) or "structured". It stays
+// in effect for later initializations; runSimulator and stepN always run untraced.
+std::string setTraceLevel(std::string name) {
+    TraceLevel level;
+    if (!parseTraceLevel(name, level)) {
+        return "ERROR: Unknown trace level " + name;
+    }
+    traceLevel = level;
+    if (session != nullptr) session->simulator().set_trace(level);
+    return "SUCCESS: Trace level " + name;
+}
+
 // Execute one cycle
 std::string stepSimulator() {
-    if (!isInitialized || globalSim == nullptr) {
+    if (!isInitialized || session == nullptr) {
         return "ERROR: Simulator not initialized";
     }
     
     try {
-        globalSim->step();
+        session->simulator().step();
+        refreshViews();
         return "SUCCESS: Executed 1 cycle";
     } catch (const std::exception& e) {
         return std::string("ERROR: ") + e.what();
     }
 }
 
-// Run until completion (max 10000 cycles for safety)
+// Execute up to n cycles and return what each one changed as a Uint32Array (layout in
+// step_batch.hpp). The array views Wasm memory: read it before the next stepN call.
+emscripten::val stepN(unsigned int n) {
+    if (!isInitialized || session == nullptr) {
+        batchBuffer.assign(1, 0);
+    } else {
+        // The per-cycle diffs are the output: formatting a trace as well would only cost time
+        session->simulator().set_trace(TraceLevel::Off);
+        step_batch(session->simulator(), n, batchBuffer);
+        session->simulator().set_trace(traceLevel);
+        refreshViews();
+    }
+    return emscripten::val(emscripten::typed_memory_view(batchBuffer.size(), batchBuffer.data()));
+}
+
+// Run until completion (max 10000 cycles, since this blocks the calling thread).
+// Long runs belong in sim_worker.js, which calls runCycles in slices with no cap.
 std::string runSimulator() {
-    if (!isInitialized || globalSim == nullptr) {
+    if (!isInitialized || session == nullptr) {
         return "ERROR: Simulator not initialized";
     }
     
     try {
-        int maxCycles = 10000;
-        int cyclesRun = 0;
-        uint32_t lastAddr = globalInstructions.back().address + 4;
-        
-        while (globalSim->get_pc() <= lastAddr && cyclesRun < maxCycles) {
-            globalSim->step();
-            cyclesRun++;
-        }
-        
+        session->simulator().set_trace(TraceLevel::Off);  // A bulk run: no per-cycle narration
+        uint64_t cyclesRun = session->simulator().run(10000);
+        session->simulator().set_trace(traceLevel);
+        refreshViews();
         return "SUCCESS: Executed " + std::to_string(cyclesRun) + " cycles";
     } catch (const std::exception& e) {
         return std::string("ERROR: ") + e.what();
     }
 }
 
+// Run up to n cycles (stops early on halt); returns the number run. One slice of a worker run.
+double runCycles(unsigned int n) {
+    if (!isInitialized || session == nullptr || n == 0) return 0;
+    uint64_t cyclesRun = session->simulator().run(n);
+    refreshViews();
+    return (double)cyclesRun;
+}
+
 // Reset simulator
 std::string resetSimulator() {
-    if (!isInitialized || globalSim == nullptr) {
+    if (!isInitialized || session == nullptr) {
         return "ERROR: Simulator not initialized";
     }
     
-    try {
-        delete globalSim;
-        globalSim = new RISCV_Simulator(INSTRUCTION_MEMORY);
-        
-        // Reload data segment
-        if (!DATA_SEGMENT.empty()) {
-            for (auto const& [addr, val] : DATA_SEGMENT) {
-                globalSim->set_memory(addr,     val & 0xFF);
-                globalSim->set_memory(addr + 1, (val >> 8) & 0xFF);
-                globalSim->set_memory(addr + 2, (val >> 16) & 0xFF);
-                globalSim->set_memory(addr + 3, (val >> 24) & 0xFF);
-            }
-        }
-        
-        return "SUCCESS: Simulator reset";
-    } catch (const std::exception& e) {
-        return std::string("ERROR: ") + e.what();
+    // Back to the state right after initialization; memory pages are shared, not reloaded
+    session->reset();
+    refreshViews();
+    return "SUCCESS: Simulator reset";
+}
+
+// Save the current state; returns an id for restoreCheckpoint (0 if not initialized)
+int saveCheckpoint() {
+    if (!isInitialized || session == nullptr) return 0;
+    int id = nextCheckpointId++;
+    checkpoints[id] = session->simulator().snapshot();
+    return id;
+}
+
+// Return to a saved state. The checkpoint stays available for further restores.
+std::string restoreCheckpoint(int id) {
+    if (!isInitialized || session == nullptr) {
+        return "ERROR: Simulator not initialized";
+    }
+    auto it = checkpoints.find(id);
+    if (it == checkpoints.end()) {
+        return "ERROR: No checkpoint " + std::to_string(id);
+    }
+    session->simulator().restore(it->second);
+    refreshViews();
+    return "SUCCESS: Restored checkpoint " + std::to_string(id) + " (cycle " + std::to_string(session->simulator().get_cycle()) + ")";
+}
+
+// Release a checkpoint and the memory pages only it was holding
+void deleteCheckpoint(int id) {
+    checkpoints.erase(id);
+}
+
+// Undo the last n cycles
+std::string stepBack(unsigned int n) {
+    if (!isInitialized || session == nullptr) {
+        return "ERROR: Simulator not initialized";
+    }
+    if (!session->simulator().step_back(n)) {
+        return "ERROR: History does not reach back " + std::to_string(n) + " cycles";
     }
+    refreshViews();
+    return "SUCCESS: Back at cycle " + std::to_string(session->simulator().get_cycle());
+}
+
+// Move to any cycle: backwards through the history, forwards by stepping
+std::string seekToCycle(unsigned int target) {
+    if (!isInitialized || session == nullptr) {
+        return "ERROR: Simulator not initialized";
+    }
+    if (!session->simulator().seek_to_cycle(target)) {
+        return "ERROR: Cycle " + std::to_string(target) + " is before the recorded history (earliest " +
+               std::to_string(session->simulator().get_history_start()) + ")";
+    }
+    refreshViews();
+    return "SUCCESS: At cycle " + std::to_string(session->simulator().get_cycle());
+}
+
+// Turn cycle recording for stepBack/seekToCycle on or off (on after initialize).
+// A worker doing long runs turns it off: recording costs a journal write every cycle.
+void setHistoryEnabled(bool enabled) {
+    if (!isInitialized || session == nullptr) return;
+    if (enabled && !session->simulator().history_enabled()) session->simulator().enable_history();
+    if (!enabled) session->simulator().disable_history();
+}
+
+// Earliest cycle seekToCycle can go back to
+double getHistoryStart() {
+    if (!isInitialized || session == nullptr) return 0;
+    return (double)session->simulator().get_history_start();
+}
+
+// True once the program has run off the end and the pipeline is empty
+bool isHalted() {
+    if (!isInitialized || session == nullptr) return true;
+    return session->simulator().is_halted();
 }
 
 // Get current PC
 uint32_t getPC() {
-    if (!isInitialized || globalSim == nullptr) return 0;
-    return globalSim->get_pc();
+    if (!isInitialized || session == nullptr) return 0;
+    return session->simulator().get_pc();
 }
 
 // Get register value
 int32_t getRegister(int idx) {
-    if (!isInitialized || globalSim == nullptr) return 0;
+    if (!isInitialized || session == nullptr) return 0;
     if (idx < 0 || idx > 31) return 0;
-    return globalSim->get_reg(idx);
+    return session->simulator().get_reg(idx);
+}
+
+// Zero-copy views on the Wasm heap. Each returns a typed array over the simulator's own
+// storage, so JS reads the whole state without a call per element. Growing the heap
+// (ALLOW_MEMORY_GROWTH) detaches every view (byteLength becomes 0): call the getter
+// again then, and after initializeSimulator, which replaces the simulator.
+
+// Int32Array of the 32 registers; stays live across steps, resets and restores
+emscripten::val getRegisterView() {
+    if (!isInitialized || session == nullptr) {
+        return emscripten::val(emscripten::typed_memory_view(0, (const int32_t*)nullptr));
+    }
+    return emscripten::val(emscripten::typed_memory_view(32, session->simulator().register_file()));
+}
+
+// Uint32Array of the LatchWords fields (pipeline_structs.hpp order); signed fields need `| 0`
+emscripten::val getLatchView() {
+    return emscripten::val(emscripten::typed_memory_view(LATCH_WORDS, reinterpret_cast<const uint32_t*>(&latchWords)));
+}
+
+// Uint8Array of the 4 KiB page holding addr (zeros where memory was never written). The
+// simulator's own pages move on copy-on-write, reset and restore, so the view is over a
+// copy that every step, store, reset, restore and initializeSimulator refreshes in place:
+// it stays live like the register view. The copy is kept for as long as the module runs.
+emscripten::val getMemoryPageView(uint32_t addr) {
+    uint32_t pageNumber = addr / SparseMemory::PAGE_SIZE;
+    std::unique_ptr<uint8_t[]>& buffer = pageViews[pageNumber];
+    if (!buffer) {
+        buffer.reset(new uint8_t[SparseMemory::PAGE_SIZE]);
+        refreshPageView(pageNumber, buffer.get());
+    }
+    return emscripten::val(emscripten::typed_memory_view(SparseMemory::PAGE_SIZE, buffer.get()));
 }
 
 // Set register value
 std::string setRegister(int idx, int32_t value) {
-    if (!isInitialized || globalSim == nullptr) {
+    if (!isInitialized || session == nullptr) {
         return "ERROR: Simulator not initialized";
     }
     if (idx < 1 || idx > 31) {
         return "ERROR: Invalid register index (must be 1-31)";
     }
     
-    globalSim->set_reg(idx, value);
+    session->simulator().set_reg(idx, value);
     return "SUCCESS: Register x" + std::to_string(idx) + " set to " + std::to_string(value);
 }
 
-// Get memory byte
-uint8_t getMemoryByte(int addr) {
-    if (!isInitialized || globalSim == nullptr) return 0;
-    if (addr < 0 || addr > 127) return 0;
-    return globalSim->get_mem(addr);
+// Get memory byte (any 32-bit address; untouched memory reads as 0)
+uint8_t getMemoryByte(uint32_t addr) {
+    if (!isInitialized || session == nullptr) return 0;
+    return session->simulator().get_mem(addr);
 }
 
 // Get memory word (32-bit)
-int32_t getMemoryWord(int addr) {
-    if (!isInitialized || globalSim == nullptr) return 0;
-    if (addr < 0 || addr > 124) return 0;
-    
-    return globalSim->get_mem(addr) | 
-           (globalSim->get_mem(addr+1) << 8) | 
-           (globalSim->get_mem(addr+2) << 16) | 
-           (globalSim->get_mem(addr+3) << 24);
+int32_t getMemoryWord(uint32_t addr) {
+    if (!isInitialized || session == nullptr) return 0;
+    return (int32_t)session->simulator().get_mem_word(addr);
 }
 
 // Set memory byte
-std::string setMemoryByte(int addr, uint8_t value) {
-    if (!isInitialized || globalSim == nullptr) {
+std::string setMemoryByte(uint32_t addr, uint8_t value) {
+    if (!isInitialized || session == nullptr) {
         return "ERROR: Simulator not initialized";
     }
-    if (addr < 0 || addr > 127) {
-        return "ERROR: Invalid memory address (must be 0-127)";
-    }
     
-    globalSim->set_memory(addr, value);
+    session->simulator().set_memory(addr, value);
+    refreshViews();
     return "SUCCESS: Memory[" + std::to_string(addr) + "] set to " + std::to_string(value);
 }
 
 // Set memory word (32-bit)
-std::string setMemoryWord(int addr, int32_t value) {
-    if (!isInitialized || globalSim == nullptr) {
+std::string setMemoryWord(uint32_t addr, int32_t value) {
+    if (!isInitialized || session == nullptr) {
         return "ERROR: Simulator not initialized";
     }
-    if (addr < 0 || addr > 124) {
-        return "ERROR: Invalid memory address (must be 0-124)";
-    }
-    
-    globalSim->set_memory(addr,     value & 0xFF);
-    globalSim->set_memory(addr + 1, (value >> 8) & 0xFF);
-    globalSim->set_memory(addr + 2, (value >> 16) & 0xFF);
-    globalSim->set_memory(addr + 3, (value >> 24) & 0xFF);
     
+    session->simulator().set_memory_word(addr, (uint32_t)value);
+    refreshViews();
     return "SUCCESS: Memory[" + std::to_string(addr) + "] (word) set to " + std::to_string(value);
 }
 
@@ -250,15 +399,15 @@ std::string setMemoryWord(int addr, int32_t value) {
 PipelineStateJS getPipelineState() {
     PipelineStateJS state;
     
-    if (!isInitialized || globalSim == nullptr) {
+    if (!isInitialized || session == nullptr) {
         memset(&state, 0, sizeof(state));
         return state;
     }
     
-    IF_ID if_id = globalSim->get_if_id();
-    ID_EX id_ex = globalSim->get_id_ex();
-    EX_MEM ex_mem = globalSim->get_ex_mem();
-    MEM_WB mem_wb = globalSim->get_mem_wb();
+    IF_ID if_id = session->simulator().get_if_id();
+    ID_EX id_ex = session->simulator().get_id_ex();
+    EX_MEM ex_mem = session->simulator().get_ex_mem();
+    MEM_WB mem_wb = session->simulator().get_mem_wb();
     
     state.if_id_pc = if_id.PC;
     state.if_id_ir = if_id.IR;
@@ -284,15 +433,75 @@ PipelineStateJS getPipelineState() {
     return state;
 }
 
+// Get branch predictor statistics
+PredictorStatsJS getPredictorStats() {
+    PredictorStatsJS stats = {0, 0, 0, 1.0};
+    if (!isInitialized || session == nullptr) return stats;
+
+    const PredictorStats& s = session->simulator().get_predictor_stats();
+    stats.branches = (double)s.branches;
+    stats.taken = (double)s.taken;
+    stats.mispredicts = (double)s.mispredicts;
+    stats.accuracy = s.accuracy();
+    return stats;
+}
+
+// Get I-cache (data=false) or D-cache (data=true) statistics
+CacheStatsJS getCacheStats(bool data) {
+    CacheStatsJS js;
+    memset(&js, 0, sizeof(js));
+    if (!isInitialized || session == nullptr) return js;
+
+    const CacheStats& s = data ? session->simulator().get_dcache_stats() : session->simulator().get_icache_stats();
+    PerfCounters c = session->simulator().get_counters();
+    js.enabled = data ? session->simulator().get_config().dcache.enabled : session->simulator().get_config().icache.enabled;
+    js.reads = (double)s.reads;
+    js.writes = (double)s.writes;
+    js.hits = (double)s.hits;
+    js.misses = (double)s.misses;
+    js.evictions = (double)s.evictions;
+    js.writebacks = (double)s.writebacks;
+    js.hit_rate = s.hit_rate();
+    js.stall_cycles = (double)(data ? c.dcache_stall_cycles : c.icache_stall_cycles);
+    return js;
+}
+
+// Get performance counters (CPI/IPC derived)
+PerfCountersJS getPerfCounters() {
+    PerfCountersJS js;
+    memset(&js, 0, sizeof(js));
+    if (!isInitialized || session == nullptr) return js;
+
+    PerfCounters c = session->simulator().get_counters();
+    js.cycles = (double)c.cycles;
+    js.instret = (double)c.instret;
+    js.raw_stalls_ex = (double)c.raw_stalls_ex;
+    js.raw_stalls_mem = (double)c.raw_stalls_mem;
+    js.raw_stalls_wb = (double)c.raw_stalls_wb;
+    js.control_flushes = (double)c.control_flushes;
+    js.bubbles = (double)c.bubbles;
+    js.loads = (double)c.loads;
+    js.stores = (double)c.stores;
+    js.branches = (double)c.branches;
+    js.muldiv = (double)c.muldiv;
+    js.ex_busy_stalls = (double)c.ex_busy_stalls;
+    js.icache_stall_cycles = (double)c.icache_stall_cycles;
+    js.dcache_stall_cycles = (double)c.dcache_stall_cycles;
+    js.cpi = c.cpi();
+    js.ipc = c.ipc();
+    return js;
+}
+
 // Get assembly listing
 std::string getAssemblyListing() {
-    if (!isInitialized || globalInstructions.empty()) {
+    if (!isInitialized || session == nullptr || session->get_program().instructions.empty()) {
         return "";
     }
     
+    const Program& program = session->get_program();
     std::stringstream ss;
-    for (const ParsedInstruction& inst : globalInstructions) {
-        unsigned int opcode = INSTRUCTION_MEMORY.at(inst.address);
+    for (const ParsedInstruction& inst : program.instructions) {
+        unsigned int opcode = program.machine_code.at((inst.address - INSTRUCTION_MEMORY_START) >> 2);
         ss << "0x" << std::hex << std::setw(8) << std::setfill('0') << inst.address
            << " | 0x" << std::hex << std::setw(8) << std::setfill('0') << opcode
            << " | " << inst.originalLine << "\n";
@@ -304,17 +513,36 @@ std::string getAssemblyListing() {
 // Emscripten bindings
 EMSCRIPTEN_BINDINGS(riscv_simulator) {
     emscripten::function("initializeSimulator", &initializeSimulator);
+    emscripten::function("initializeSimulatorWithOptions", &initializeSimulatorWithOptions);
+    emscripten::function("getSimulatorOptions", &getSimulatorOptions);
+    emscripten::function("setTraceLevel", &setTraceLevel);
     emscripten::function("stepSimulator", &stepSimulator);
+    emscripten::function("stepN", &stepN);
     emscripten::function("runSimulator", &runSimulator);
+    emscripten::function("runCycles", &runCycles);
     emscripten::function("resetSimulator", &resetSimulator);
+    emscripten::function("saveCheckpoint", &saveCheckpoint);
+    emscripten::function("restoreCheckpoint", &restoreCheckpoint);
+    emscripten::function("deleteCheckpoint", &deleteCheckpoint);
+    emscripten::function("stepBack", &stepBack);
+    emscripten::function("seekToCycle", &seekToCycle);
+    emscripten::function("getHistoryStart", &getHistoryStart);
+    emscripten::function("setHistoryEnabled", &setHistoryEnabled);
+    emscripten::function("isHalted", &isHalted);
     emscripten::function("getPC", &getPC);
     emscripten::function("getRegister", &getRegister);
+    emscripten::function("getRegisterView", &getRegisterView);
+    emscripten::function("getLatchView", &getLatchView);
+    emscripten::function("getMemoryPageView", &getMemoryPageView);
     emscripten::function("setRegister", &setRegister);
     emscripten::function("getMemoryByte", &getMemoryByte);
     emscripten::function("getMemoryWord", &getMemoryWord);
     emscripten::function("setMemoryByte", &setMemoryByte);
     emscripten::function("setMemoryWord", &setMemoryWord);
     emscripten::function("getPipelineState", &getPipelineState);
+    emscripten::function("getPerfCounters", &getPerfCounters);
+    emscripten::function("getPredictorStats", &getPredictorStats);
+    emscripten::function("getCacheStats", &getCacheStats);
     emscripten::function("getAssemblyListing", &getAssemblyListing);
     
     value_object<PipelineStateJS>("PipelineStateJS")
@@ -335,4 +563,39 @@ EMSCRIPTEN_BINDINGS(riscv_simulator) {
         .field("mem_wb_lmd", &PipelineStateJS::mem_wb_lmd)
         .field("mem_wb_rd", &PipelineStateJS::mem_wb_rd)
         .field("mem_wb_regwrite", &PipelineStateJS::mem_wb_regwrite);
+
+    value_object<PerfCountersJS>("PerfCountersJS")
+        .field("cycles", &PerfCountersJS::cycles)
+        .field("instret", &PerfCountersJS::instret)
+        .field("raw_stalls_ex", &PerfCountersJS::raw_stalls_ex)
+        .field("raw_stalls_mem", &PerfCountersJS::raw_stalls_mem)
+        .field("raw_stalls_wb", &PerfCountersJS::raw_stalls_wb)
+        .field("control_flushes", &PerfCountersJS::control_flushes)
+        .field("bubbles", &PerfCountersJS::bubbles)
+        .field("loads", &PerfCountersJS::loads)
+        .field("stores", &PerfCountersJS::stores)
+        .field("branches", &PerfCountersJS::branches)
+        .field("muldiv", &PerfCountersJS::muldiv)
+        .field("ex_busy_stalls", &PerfCountersJS::ex_busy_stalls)
+        .field("icache_stall_cycles", &PerfCountersJS::icache_stall_cycles)
+        .field("dcache_stall_cycles", &PerfCountersJS::dcache_stall_cycles)
+        .field("cpi", &PerfCountersJS::cpi)
+        .field("ipc", &PerfCountersJS::ipc);
+
+    value_object<PredictorStatsJS>("PredictorStatsJS")
+        .field("branches", &PredictorStatsJS::branches)
+        .field("taken", &PredictorStatsJS::taken)
+        .field("mispredicts", &PredictorStatsJS::mispredicts)
+        .field("accuracy", &PredictorStatsJS::accuracy);
+
+    value_object<CacheStatsJS>("CacheStatsJS")
+        .field("enabled", &CacheStatsJS::enabled)
+        .field("reads", &CacheStatsJS::reads)
+        .field("writes", &CacheStatsJS::writes)
+        .field("hits", &CacheStatsJS::hits)
+        .field("misses", &CacheStatsJS::misses)
+        .field("evictions", &CacheStatsJS::evictions)
+        .field("writebacks", &CacheStatsJS::writebacks)
+        .field("hit_rate", &CacheStatsJS::hit_rate)
+        .field("stall_cycles", &CacheStatsJS::stall_cycles);
 }
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "../hpp_files/memory.hpp"
+#include <vector>
+
+uint8_t* SparseMemory::page_for_write(uint32_t addr) {
+    std::shared_ptr<Directory>& dir = dirs[dir_index(addr)];
+    if (!dir) dir = std::make_shared<Directory>();
+    else if (dir.use_count() > 1) dir = std::make_shared<Directory>(*dir);  // Shared with a snapshot
+
+    std::shared_ptr<Page>& page = dir->pages[page_index(addr)];
+    if (!page) {
+        page = std::make_shared<Page>();  // Value-initialized: zero-filled
+        allocated_pages++;
+    } else if (page.use_count() > 1) {
+        page = std::make_shared<Page>(*page);
+    }
+    return page->bytes;
+}
+
+void SparseMemory::write_block(uint32_t addr, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t chunk = PAGE_SIZE - offset(addr);
+        if (chunk > len) chunk = len;
+        std::memcpy(page_for_write(addr) + offset(addr), data, chunk);
+        addr += (uint32_t)chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+void SparseMemory::load_words(const std::map<unsigned int, int32_t>& words) {
+    std::vector<uint8_t> run;
+    uint32_t run_start = 0;
+
+    for (auto const& [addr, val] : words) {
+        if (!run.empty() && addr != run_start + run.size()) {
+            write_block(run_start, run.data(), run.size());
+            run.clear();
+        }
+        if (run.empty()) run_start = addr;
+        run.push_back(val & 0xFF);
+        run.push_back((val >> 8) & 0xFF);
+        run.push_back((val >> 16) & 0xFF);
+        run.push_back((val >> 24) & 0xFF);
+    }
+    if (!run.empty()) write_block(run_start, run.data(), run.size());
+}
+
+void SparseMemory::clear() {
+    for (uint32_t d = 0; d < DIR_SIZE; d++) dirs[d].reset();
+    allocated_pages = 0;
+}
+
+SparseMemory::Snapshot SparseMemory::snapshot() const {
+    Snapshot snap;
+    for (uint32_t d = 0; d < DIR_SIZE; d++) snap.dirs[d] = dirs[d];
+    snap.allocated_pages = allocated_pages;
+    return snap;
+}
+
+void SparseMemory::restore(const Snapshot& snap) {
+    for (uint32_t d = 0; d < DIR_SIZE; d++) dirs[d] = snap.dirs[d];
+    allocated_pages = snap.allocated_pages;
+}
+
+void SparseMemory::for_each_page(const std::function<void(uint32_t base, const uint8_t* bytes)>& visit) const {
+    for (uint32_t d = 0; d < DIR_SIZE; d++) {
+        if (!dirs[d]) continue;
+        for (uint32_t p = 0; p < DIR_SIZE; p++) {
+            const Page* page = dirs[d]->pages[p].get();
+            if (page) visit((d << (PAGE_BITS + DIR_BITS)) | (p << PAGE_BITS), page->bytes);
+        }
+    }
+}
+
+bool SparseMemory::equals(const SparseMemory& other, uint32_t* first_diff) const {
+    static const uint8_t zero_page[PAGE_SIZE] = {0};
+
+    for (uint32_t d = 0; d < DIR_SIZE; d++) {
+        const Directory* a = dirs[d].get();
+        const Directory* b = other.dirs[d].get();
+        if (a == b) continue;  // Both empty, or one directory shared through a snapshot
+
+        for (uint32_t p = 0; p < DIR_SIZE; p++) {
+            const uint8_t* pa = (a && a->pages[p]) ? a->pages[p]->bytes : zero_page;
+            const uint8_t* pb = (b && b->pages[p]) ? b->pages[p]->bytes : zero_page;
+            if (pa == pb || std::memcmp(pa, pb, PAGE_SIZE) == 0) continue;
+
+            if (first_diff) {
+                uint32_t i = 0;
+                while (pa[i] == pb[i]) i++;
+                *first_diff = (d << (PAGE_BITS + DIR_BITS)) | (p << PAGE_BITS) | i;
+            }
+            return false;
+        }
+    }
+    return true;
+}
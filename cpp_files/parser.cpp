@@ -1,240 +1,341 @@
-#include "../hpp_files/assembler.hpp"
-#include "../hpp_files/utils.hpp"
+#include "../hpp_files/parser.hpp"
+#include "../hpp_files/encoder.hpp"
+#include "../hpp_files/instruction_set.hpp"
+#include <stdexcept>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PARSER_USE_MMAP 1
+#endif
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
 
-vector<string> readAndPreprocess(const string& filename);
-map<string, unsigned int> buildSymbolTable(const vector<string>& lines);
-vector<ParsedInstruction> parseInstructions(const vector<string>& lines);
-bool validateInstructions(const vector<ParsedInstruction>& instructions);
-void parseDataSection(const vector<string>& lines);
+static string_view trim(string_view s) {
+    size_t first = 0, last = s.size();
+    while (first < last && isBlank(s[first])) first++;
+    while (last > first && isBlank(s[last - 1])) last--;
+    return s.substr(first, last - first);
+}
 
-// Definition of the global data map (declared extern in assembler.hpp)
-map<unsigned int, int32_t> DATA_SEGMENT;
+// Leading run of non-blank characters; `s` must already be trimmed
+static string_view firstWord(string_view s) {
+    size_t end = 0;
+    while (end < s.size() && !isBlank(s[end])) end++;
+    return s.substr(0, end);
+}
 
-/**
- * Reads the file, ignores comments, and collects non-empty lines.
- * UPDATED: Now keeps lines starting with '.' (directives like .data, .text)
- */
-vector<string> readAndPreprocess(const string& filename) {
-    vector<string> lines;
-    ifstream file(filename);
+[[noreturn]] static void lineError(unsigned lineNumber, string_view line, const string& message) {
+    throw std::invalid_argument(message + " on line " + to_string(lineNumber) + ": " + string(line));
+}
+
+// Operands an instruction of this format is parsed into
+static uint8_t operandCount(InstFormat format) {
+    return (format == InstFormat::U || format == InstFormat::J) ? 2 : 3;
+}
+
+string readSourceFile(const string& filename) {
+    ifstream file(filename, ios::binary);
     if (!file.is_open()) {
-        cerr << "ERROR: Could not open file " << filename << endl;
-        exit(1);
+        throw std::runtime_error("Could not open file " + filename);
+    }
+    string source;
+    file.seekg(0, ios::end);
+    streamoff size = file.tellg();
+    if (size >= 0) {
+        source.resize((size_t)size);
+        file.seekg(0, ios::beg);
+        file.read(&source[0], (streamsize)source.size());
+        return source;
     }
 
-    string line;
-    while (getline(file, line)) {
-        size_t commentPos = line.find('#');
-        if (commentPos != string::npos) {
-            line = line.substr(0, commentPos);
-        }
-
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    // A pipe cannot seek, so its size is unknown: read until it ends
+    file.clear();
+    char chunk[1 << 16];
+    while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+        source.append(chunk, (size_t)file.gcount());
+    }
+    return source;
+}
 
-        if (!line.empty()) {
-            // UPDATED: We NO LONGER ignore .word and .text lines here.
-            // We need them for section tracking.
-            lines.push_back(line);
+/**
+ * Splits "a, b, c" on commas into trimmed, non-empty tokens.
+ * Returns the number of tokens, or max + 1 if there are more than max.
+ */
+static size_t splitOperands(string_view rest, string_view* out, size_t max) {
+    size_t count = 0;
+    while (true) {
+        size_t comma = rest.find(',');
+        string_view token = trim(rest.substr(0, comma));
+        if (!token.empty()) {
+            if (count == max) return max + 1;
+            out[count++] = token;
         }
+        if (comma == string_view::npos) return count;
+        rest.remove_prefix(comma + 1);
     }
-    
-    return lines;
 }
 
 /**
- * Pass 1: build the Symbol Table.
- * UPDATED: Handles separate counters for .text (0x80) and .data (0x00)
+ * Fills in the operands of an instruction from the text after its mnemonic.
+ * Loads and stores are written "reg, imm(rs1)" and stored as reg, rs1, imm.
  */
-map<string, unsigned int> buildSymbolTable(const vector<string>& lines) {
-    map<string, unsigned int> symbolTable;
-    unsigned int textAddress = INSTRUCTION_MEMORY_START; // 0x80
-    unsigned int dataAddress = DATA_MEMORY_START;        // 0x00
-    bool inDataSegment = false; // Default to text
-
-    for (const string& line : lines) {
-        string tempLine = line;
+static void parseOperands(ParsedInstruction& inst, string_view rest) {
+    if (inst.def->format == InstFormat::Load || inst.def->format == InstFormat::S) {
+        string_view parts[2];
+        if (splitOperands(rest, parts, 2) != 2) {
+            lineError(inst.line, inst.originalLine, "Incorrect operand count for " + string(inst.mnemonic));
+        }
 
-        // Handle Section Directives
-        if (tempLine == ".data") { inDataSegment = true; continue; }
-        if (tempLine == ".text") { inDataSegment = false; continue; }
-        if (tempLine.find(".global") != string::npos) continue; 
-
-        // Check for a label (ends with ':')
-        size_t labelPos = tempLine.find(':');
-        if (labelPos != string::npos) {
-            // Extract label name (before the ':')
-            string label = tempLine.substr(0, labelPos);
-            label.erase(remove_if(label.begin(), label.end(), ::isspace), label.end());
-            
-            if (symbolTable.count(label)) {
-                cerr << "ERROR: Duplicate label definition: " << label << endl;
-                exit(1);
-            }
-            
-            // Assign address based on current section
-            if (inDataSegment) {
-                symbolTable[label] = dataAddress;
-            } else {
-                symbolTable[label] = textAddress;
-            }
-            
-            // Process the rest of the line (e.g., "label: .word 5" or "label: add...")
-            tempLine = tempLine.substr(labelPos + 1);
-            tempLine.erase(0, tempLine.find_first_not_of(" \t\r\n"));
+        // Find the opening '(' and closing ')'
+        size_t openParen = parts[1].find('(');
+        size_t closeParen = parts[1].find(')');
+        if (openParen == string_view::npos || closeParen == string_view::npos || closeParen < openParen) {
+            lineError(inst.line, inst.originalLine,
+                      "Invalid address format for " + string(inst.mnemonic) + ". Expected: imm(rs1)");
         }
 
-        if (tempLine.empty()) continue;
+        inst.operands[0] = parts[0];                                                      // rd for loads and jalr, rs2 for stores
+        inst.operands[1] = trim(parts[1].substr(openParen + 1, closeParen - openParen - 1));  // rs1
+        inst.operands[2] = trim(parts[1].substr(0, openParen));                          // imm
+        inst.operand_count = 3;
+        return;
+    }
 
-        // Increment Address Counter
-        if (inDataSegment) {
-            // Check for .word directive (allocates 4 bytes)
-            stringstream ss(tempLine);
-            string firstWord;
-            ss >> firstWord;
-            if (firstWord == ".word") {
-                dataAddress += 4;
-            }
-        } else {
-            // Instructions in .text segment take 4 bytes
-            textAddress += 4;
-        }
+    inst.operand_count = (uint8_t)splitOperands(rest, inst.operands, 3);
+    if (inst.operand_count != operandCount(inst.def->format)) {
+        lineError(inst.line, inst.originalLine, "Incorrect operand count for " + string(inst.mnemonic));
     }
-    return symbolTable;
 }
 
 /**
- * NEW FUNCTION: Extracts values from .word directives in the .data section
+ * Rejects operands the encoders would otherwise mask into their fields: names that
+ * are not registers, and immediates that are not numbers or do not fit.
  */
-void parseDataSection(const vector<string>& lines) {
-    unsigned int currentAddress = DATA_MEMORY_START; // 0x00
-    bool inDataSegment = false;
-
-    for (const string& line : lines) {
-        string tempLine = line;
-
-        // Handle Section Directives
-        if (tempLine == ".data") { inDataSegment = true; continue; }
-        if (tempLine == ".text") { inDataSegment = false; continue; }
-
-        // Remove label if present
-        size_t labelPos = tempLine.find(':');
-        if (labelPos != string::npos) {
-            tempLine = tempLine.substr(labelPos + 1);
-            tempLine.erase(0, tempLine.find_first_not_of(" \t\r\n"));
+static void checkOperands(const ParsedInstruction& inst) {
+    InstFormat format = inst.def->format;
+    size_t registers = format == InstFormat::R ? 3 : inst.operand_count - 1u;  // The rest is an immediate or label
+    for (size_t i = 0; i < registers; i++) {
+        if (getRegisterNumber(inst.operands[i]) < 0) {
+            lineError(inst.line, inst.originalLine, "Invalid register " + string(inst.operands[i]));
         }
+    }
+    if (format == InstFormat::R || format == InstFormat::B || format == InstFormat::J) return;
 
-        if (tempLine.empty()) continue;
-
-        if (inDataSegment) {
-            stringstream ss(tempLine);
-            string directive;
-            ss >> directive;
-            
-            if (directive == ".word") {
-                string valueStr;
-                ss >> valueStr; // Read the value after .word
-                int value = getImmediateValue(valueStr); // Use util function to parse hex/dec
-                
-                // Store in global data map
-                DATA_SEGMENT[currentAddress] = value;
-                currentAddress += 4;
-            }
-        }
+    string_view token = inst.operands[inst.operand_count - 1];
+    int value = 0;
+    if (!parseImmediate(token, value)) {
+        lineError(inst.line, inst.originalLine, "Invalid immediate " + string(token));
+    }
+    int low = -2048, high = 2047;                                            // 12-bit signed
+    if (format == InstFormat::IShift) { low = 0; high = 31; }                 // shamt
+    if (format == InstFormat::U) { low = -(1 << 19); high = (1 << 20) - 1; }  // 20 bits, signed or not
+    if (value < low || value > high) {
+        lineError(inst.line, inst.originalLine, "Immediate " + string(token) + " out of range [" +
+                  to_string(low) + ", " + to_string(high) + "]");
     }
 }
 
-// Assembler Phase 2: Parsing, Validation & Encoding Setup
+// Branches reach +/-4 KiB and JAL +/-1 MiB, in steps of 2 bytes
+static void checkOffset(InstFormat format, int32_t offset, unsigned lineNumber, string_view line) {
+    int32_t reach = format == InstFormat::J ? (1 << 20) : (1 << 12);
+    if (offset < -reach || offset >= reach) {
+        lineError(lineNumber, line, "Branch target out of range (offset " + to_string(offset) + ")");
+    }
+    if (offset & 1) {
+        lineError(lineNumber, line, "Branch target not 2-byte aligned (offset " + to_string(offset) + ")");
+    }
+}
 
+#ifdef PARSER_USE_MMAP
 /**
- * Pass 2: Parses instructions and prepares them for encoding.
- * UPDATED: Now skips over .data sections and directives.
+ * A read-only mapping of a whole file, unmapped along with the last Program sharing it.
+ * Clean file pages can be dropped at any time and are read back from the file when
+ * touched again, so the scan releases what it has passed.
  */
-vector<ParsedInstruction> parseInstructions(const vector<string>& lines) {
-    vector<ParsedInstruction> instructions;
-    unsigned int currentAddress = INSTRUCTION_MEMORY_START;
-    bool inTextSegment = true; // Assume start in text unless .data seen first
-
-    // Initial scan to set correct start state if file starts with .data
-    bool hasDirectives = false;
-    for(const auto& l : lines) if(l == ".text" || l == ".data") hasDirectives = true;
-    if(!hasDirectives) inTextSegment = true;
-
-    for (const string& line : lines) {
-        string currentLine = line;
-        
-        // Handle Section switching
-        if (currentLine == ".data") { inTextSegment = false; continue; }
-        if (currentLine == ".text") { inTextSegment = true; continue; }
-        if (currentLine.find(".global") != string::npos) continue;
-
-        // If we are in the data segment, DO NOT parse as instructions
-        if (!inTextSegment) continue;
-
-        size_t labelPos = currentLine.find(':');
-        if (labelPos != string::npos) {
-            currentLine = currentLine.substr(labelPos + 1);
-            currentLine.erase(0, currentLine.find_first_not_of(" \t\r\n"));
-            if (currentLine.empty()) {
-                continue; 
-            }
-        }
+struct MappedFile {
+    static constexpr size_t RELEASE_CHUNK = 16 << 20;
 
-        // Check for directives inside .text (like .word shouldn't be here usually, but safety check)
-        if (currentLine[0] == '.') continue;
+    void* base = nullptr;
+    size_t size = 0;
+    size_t released = 0;
 
-        // Split into mnemonic and the rest of the operands
-        stringstream ss(currentLine);
-        string mnemonic;
-        ss >> mnemonic;
+    ~MappedFile() {
+        if (base) munmap(base, size);
+    }
 
-        if (mnemonic.empty()) continue;
+    // Called with the offset the scan has reached
+    void scanned(size_t offset) {
+        if (offset - released < RELEASE_CHUNK) return;
+        size_t end = offset & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+        madvise(base, end, MADV_DONTNEED);
+        released = end;
+    }
+};
+#else
+struct MappedFile {
+    void scanned(size_t) {}
+};
+#endif
 
-        string restOfLine;
-        getline(ss, restOfLine);
+/**
+ * Single pass over program.source. Every token is a view into the source text;
+ * .text starts at INSTRUCTION_MEMORY_START (0x80) and .data at DATA_MEMORY_START (0x00).
+ * Without keepInstructions only the machine code, data and symbols are filled in.
+ */
+static void assembleSource(Program& program, bool keepInstructions, MappedFile* mapping) {
+    string_view source = program.source;
+
+    // At most one instruction per line: reserving for that is one allocation. The
+    // streaming path skips the extra pass over the text and lets the code grow.
+    if (keepInstructions) {
+        size_t lineCount = (size_t)count(source.begin(), source.end(), '\n') + 1;
+        program.instructions.reserve(lineCount);
+        program.machine_code.reserve(lineCount);
+    }
 
-        ParsedInstruction pInst;
-        pInst.mnemonic = mnemonic;
-        pInst.address = currentAddress;
-        pInst.originalLine = line;
+    // Branches whose label was not defined yet when they were read
+    struct Fixup {
+        uint32_t index;          // Into machine_code
+        uint32_t line;
+        string_view text;        // The line, for errors
+        string_view label;
+        InstFormat format;
+    };
+    vector<Fixup> unresolved;
+    unsigned int textAddress = INSTRUCTION_MEMORY_START;
+    unsigned int dataAddress = DATA_MEMORY_START;
+    bool inDataSegment = false;  // Default to text
+    unsigned int lineNumber = 0;
+
+    while (!source.empty()) {
+        size_t newline = source.find('\n');
+        string_view raw = source.substr(0, newline);
+        source.remove_prefix(newline == string_view::npos ? source.size() : newline + 1);
+        lineNumber++;
+        if (mapping) mapping->scanned((size_t)(source.data() - program.source.data()));
+
+        string_view line = trim(raw.substr(0, raw.find('#')));
+        if (line.empty()) continue;
 
-        // Handle the special format for loads/stores: lw rd, imm(rs1)
-        if (mnemonic == "lw" || mnemonic == "sw") {
-            // Split the rest by comma: "rd/rs2, imm(rs1)"
-            vector<string> parts = split(restOfLine, ',');
-            if (parts.size() != 2) {
-                cerr << "ERROR on line: " << line << " -> Incorrect operand count for " << mnemonic << endl;
-                exit(1);
+        // Handle Section Directives
+        if (line == ".data") { inDataSegment = true; continue; }
+        if (line == ".text") { inDataSegment = false; continue; }
+        if (line.find(".global") != string_view::npos) continue;
+
+        // A label takes the address of whatever follows it in the current section
+        string_view rest = line;
+        size_t labelPos = line.find(':');
+        if (labelPos != string_view::npos) {
+            string_view label = trim(line.substr(0, labelPos));
+            unsigned int address = inDataSegment ? dataAddress : textAddress;
+            if (!program.symbols.emplace(label, address).second) {
+                lineError(lineNumber, line, "Duplicate label definition: " + string(label));
             }
-            
-            string destReg = parts[0]; // rd for lw, rs2 for sw
-            string immAndBase = parts[1]; // imm(rs1)
-
-            // Find the opening '(' and closing ')'
-            size_t openParen = immAndBase.find('(');
-            size_t closeParen = immAndBase.find(')');
+            rest = trim(line.substr(labelPos + 1));
+            if (rest.empty()) continue;
+        }
 
-            if (openParen == string::npos || closeParen == string::npos || closeParen < openParen) {
-                cerr << "ERROR on line: " << line << " -> Invalid address format for " << mnemonic << ". Expected: imm(rs1)" << endl;
-                exit(1);
+        if (inDataSegment) {
+            // .word <value> allocates 4 bytes; other directives are ignored
+            if (firstWord(rest) == ".word") {
+                string_view value = firstWord(trim(rest.substr(5)));
+                int word = 0;
+                if (!parseImmediate(value, word)) {
+                    lineError(lineNumber, line, "Invalid .word value " + string(value));
+                }
+                program.data[dataAddress] = word;
+                dataAddress += 4;
             }
+            continue;
+        }
 
-            string imm = immAndBase.substr(0, openParen);
-            string baseReg = immAndBase.substr(openParen + 1, closeParen - (openParen + 1));
+        // Directives inside .text take no space
+        if (rest[0] == '.') continue;
+
+        ParsedInstruction inst = {};
+        inst.mnemonic = firstWord(rest);
+        inst.address = textAddress;
+        inst.line = lineNumber;
+        inst.originalLine = line;
+        inst.def = findInstruction(inst.mnemonic);
+        if (!inst.def) {
+            throw std::out_of_range("Unknown instruction on line " + to_string(lineNumber) + ": " + string(inst.mnemonic));
+        }
+        parseOperands(inst, rest.substr(inst.mnemonic.size()));
+        checkOperands(inst);
+
+        // Branches and jumps to a label further down are encoded once the pass is over
+        int32_t offset = 0;
+        if (inst.def->format == InstFormat::B || inst.def->format == InstFormat::J) {
+            auto target = program.symbols.find(inst.operands[inst.operand_count - 1]);
+            if (target == program.symbols.end()) {
+                unresolved.push_back({(uint32_t)program.machine_code.size(), inst.line, line,
+                                      inst.operands[inst.operand_count - 1], inst.def->format});
+            } else {
+                offset = (int32_t)target->second - (int32_t)inst.address;
+                checkOffset(inst.def->format, offset, inst.line, line);
+            }
+        }
 
-            baseReg.erase(remove_if(baseReg.begin(), baseReg.end(), ::isspace), baseReg.end());
-            
-            pInst.operands.push_back(destReg);
-            pInst.operands.push_back(baseReg);
-            pInst.operands.push_back(imm);
+        program.machine_code.push_back(encodeInstruction(inst, offset));
+        if (keepInstructions) program.instructions.push_back(inst);
+        textAddress += 4;
+    }
 
-        } else {
-            pInst.operands = split(restOfLine, ',');
+    // Backpatch the forward references
+    for (const Fixup& fixup : unresolved) {
+        auto target = program.symbols.find(fixup.label);
+        if (target == program.symbols.end()) {
+            throw std::out_of_range("Unknown label on line " + to_string(fixup.line) + ": " + string(fixup.label));
         }
-
-        instructions.push_back(pInst);
-        currentAddress += 4;
+        int32_t offset = (int32_t)target->second - (int32_t)(INSTRUCTION_MEMORY_START + 4 * fixup.index);
+        checkOffset(fixup.format, offset, fixup.line, fixup.text);
+        program.machine_code[fixup.index] = patchOffset(program.machine_code[fixup.index], offset);
     }
+}
+
+Program assembleProgram(string text) {
+    auto owner = make_shared<const string>(std::move(text));
+    Program program;
+    program.source = *owner;
+    program.source_owner = std::move(owner);
+    assembleSource(program, true, nullptr);
+    return program;
+}
 
-    return instructions;
-}
\ No newline at end of file
+Program assembleFile(const string& filename) {
+    Program program;
+#ifdef PARSER_USE_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file " + filename);
+    }
+    struct stat st;
+    auto mapping = make_shared<MappedFile>();
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mapping->size = (size_t)st.st_size;
+        mapping->base = mmap(nullptr, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping->base == MAP_FAILED) mapping->base = nullptr;
+    }
+    close(fd);
+
+    if (mapping->base) {
+        madvise(mapping->base, mapping->size, MADV_SEQUENTIAL);
+        program.source = string_view((const char*)mapping->base, mapping->size);
+        program.source_owner = mapping;
+        assembleSource(program, false, mapping.get());
+        return program;
+    }
+    // Empty, or not mappable (a pipe, say): read it instead
+#endif
+    auto owner = make_shared<const string>(readSourceFile(filename));
+    program.source = *owner;
+    program.source_owner = std::move(owner);
+    assembleSource(program, false, nullptr);
+    return program;
+}
@@ -0,0 +1,214 @@
+#include "../hpp_files/regression.hpp"
+#include "../hpp_files/parser.hpp"
+#include "../hpp_files/session.hpp"
+#include <sstream>
+
+static bool parseNumber(const std::string& text, long long& value) {
+    try {
+        size_t used = 0;
+        value = std::stoll(text, &used, 0);  // Base 0: decimal, 0x hex
+        return used == text.size();
+    } catch (...) {
+        return false;
+    }
+}
+
+// One "key=value" check from an expect line
+static bool parseExpectation(const std::string& item, RegressionCase& c, std::string& error) {
+    size_t eq = item.find('=');
+    long long value = 0;
+    if (eq == std::string::npos || !parseNumber(item.substr(eq + 1), value)) {
+        error = "expected key=<number>, got '" + item + "'";
+        return false;
+    }
+    std::string key = item.substr(0, eq);
+
+    if (key == "cycles" || key == "instret") {
+        if (value < 0) {
+            error = key + " cannot be negative";
+            return false;
+        }
+        (key == "cycles" ? c.check_cycles : c.check_instret) = true;
+        (key == "cycles" ? c.cycles : c.instret) = (uint64_t)value;
+        return true;
+    }
+    if (key.size() > 5 && key.compare(0, 4, "mem[") == 0 && key.back() == ']') {
+        long long addr = 0;
+        if (!parseNumber(key.substr(4, key.size() - 5), addr) || addr < 0 || addr > 0xFFFFFFFFll) {
+            error = "bad memory address in '" + item + "'";
+            return false;
+        }
+        c.mem[(uint32_t)addr] = (uint32_t)value;
+        return true;
+    }
+    int reg = getRegisterNumber(key);
+    if (reg < 0) {
+        error = "unknown check '" + key + "' (xN or an ABI name, mem[addr], cycles or instret)";
+        return false;
+    }
+    c.regs[reg] = (int32_t)value;
+    return true;
+}
+
+// The items of a rewrite line: cycle=<n> followed by <addr>=<word> pairs
+static bool parseRewrite(const std::string& items_text, RegressionCase& c, std::string& error) {
+    std::istringstream items(items_text);
+    std::string item;
+    bool have_cycle = false;
+    long long cycle = 0;
+    while (items >> item) {
+        size_t eq = item.find('=');
+        long long key = 0, value = 0;
+        if (eq == std::string::npos || !parseNumber(item.substr(eq + 1), value)) {
+            error = "expected key=<number>, got '" + item + "'";
+            return false;
+        }
+        if (item.compare(0, eq, "cycle") == 0) {
+            if (value < 0) {
+                error = "cycle cannot be negative";
+                return false;
+            }
+            cycle = value;
+            have_cycle = true;
+            continue;
+        }
+        if (!have_cycle) {
+            error = "a rewrite needs cycle=<n> before its addr=word pairs";
+            return false;
+        }
+        if (!parseNumber(item.substr(0, eq), key) || key < 0 || key > 0xFFFFFFFFll) {
+            error = "bad instruction address in '" + item + "'";
+            return false;
+        }
+        c.rewrites.emplace((uint64_t)cycle, std::make_pair((uint32_t)key, (uint32_t)value));
+    }
+    if (!have_cycle) {
+        error = "a rewrite needs cycle=<n>";
+        return false;
+    }
+    return true;
+}
+
+bool splitCorpus(std::istream& in, const std::string& file, std::vector<RegressionCase>& cases, std::string& error) {
+    static const std::string EXPECT = "# expect:";
+    static const std::string REWRITE = "# rewrite:";
+
+    std::string line;
+    unsigned number = 0;
+    bool after_blank = true;  // The first line can open a case
+    bool open = false;        // A case has been started (cases.back() is it)
+
+    while (std::getline(in, line)) {
+        number++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t indent = line.find_first_not_of(" \t");
+        bool blank = indent == std::string::npos;
+        bool expect = !blank && line.compare(indent, EXPECT.size(), EXPECT) == 0;
+        bool rewrite = !blank && line.compare(indent, REWRITE.size(), REWRITE) == 0;
+
+        if (after_blank && line.size() > 1 && line[0] == '#' && !expect && !rewrite) {
+            RegressionCase c;
+            c.file = file;
+            c.line = number;
+            c.name = line.substr(1);
+            c.name.erase(0, c.name.find_first_not_of(" \t"));
+            cases.push_back(c);
+            open = true;
+        } else if (!open && !blank) {
+            RegressionCase c;  // Untitled lines at the top of the file
+            c.file = file;
+            c.line = number;
+            c.name = file;
+            cases.push_back(c);
+            open = true;
+        }
+        after_blank = blank;
+        if (!open) continue;
+
+        RegressionCase& c = cases.back();
+        c.source += line;
+        c.source += '\n';
+
+        if (expect) {
+            std::istringstream items(line.substr(indent + EXPECT.size()));
+            std::string item;
+            while (items >> item) {
+                if (!parseExpectation(item, c, error)) {
+                    error = file + ":" + std::to_string(number) + ": " + error;
+                    return false;
+                }
+            }
+        }
+        if (rewrite && !parseRewrite(line.substr(indent + REWRITE.size()), c, error)) {
+            error = file + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+RegressionResult runRegressionCase(const RegressionCase& c, const SimulatorConfig& config,
+                                   uint64_t max_cycles, bool check_cycles) {
+    RegressionResult result = {true, false, false, 0, 0, ""};
+    std::ostringstream failures;
+    auto fail = [&](const std::string& what) {
+        if (!result.passed) failures << "; ";
+        failures << what;
+        result.passed = false;
+    };
+
+    // A case that does not assemble fails on its own; the other cases still run
+    Program program;
+    try {
+        program = assembleProgram(c.source);
+    } catch (const std::exception& e) {
+        fail(std::string("does not assemble: ") + e.what());
+        result.failures = failures.str();
+        return result;
+    }
+
+    Session session(std::move(program), config);
+    RISCV_Simulator& sim = session.simulator();
+    sim.set_trace(TraceLevel::Off);
+    for (auto const& [cycle, rewrite] : c.rewrites) {
+        // Up to the rewrite's cycle, without going past max_cycles (run(0) has no limit)
+        uint64_t limit = cycle > result.cycles ? cycle - result.cycles : 0;
+        if (max_cycles != 0 && max_cycles - result.cycles < limit) limit = max_cycles - result.cycles;
+        if (limit != 0) result.cycles += sim.run(limit);
+        if (!sim.set_instruction(rewrite.first, rewrite.second)) {
+            std::ostringstream what;
+            what << "rewrite of 0x" << std::hex << rewrite.first << " is outside the program";
+            fail(what.str());
+        }
+    }
+    if (max_cycles == 0 || result.cycles < max_cycles) {
+        result.cycles += sim.run(max_cycles ? max_cycles - result.cycles : 0);
+    }
+    result.instret = sim.get_retired();
+    result.halted = sim.is_halted();
+
+    if (!result.halted) fail("did not halt within " + std::to_string(max_cycles) + " cycles");
+    if (check_cycles && c.check_cycles && result.cycles != c.cycles) {
+        result.cycle_regression = result.cycles > c.cycles;
+        fail("cycles " + std::to_string(result.cycles) + ", expected " + std::to_string(c.cycles) +
+             (result.cycle_regression ? " (REGRESSION)" : " (faster: update the annotation)"));
+    }
+    if (c.check_instret && result.instret != c.instret) {
+        fail("instret " + std::to_string(result.instret) + ", expected " + std::to_string(c.instret));
+    }
+    for (auto const& [reg, value] : c.regs) {
+        if (sim.get_reg(reg) != value) {
+            fail("x" + std::to_string(reg) + " = " + std::to_string(sim.get_reg(reg)) + ", expected " + std::to_string(value));
+        }
+    }
+    for (auto const& [addr, value] : c.mem) {
+        uint32_t actual = sim.get_mem_word(addr);
+        if (actual != value) {
+            std::ostringstream what;
+            what << "mem[0x" << std::hex << addr << "] = 0x" << actual << ", expected 0x" << value;
+            fail(what.str());
+        }
+    }
+    result.failures = failures.str();
+    return result;
+}
@@ -0,0 +1,8 @@
+#include "../hpp_files/session.hpp"
+
+Session::Session(Program prog, const SimulatorConfig& config)
+    : program(std::move(prog)), sim(program.machine_code, config)
+{
+    sim.load_data(program.data);
+    initial = sim.snapshot();
+}
@@ -0,0 +1,127 @@
+#include "../hpp_files/sim_config.hpp"
+#include <sstream>
+
+static bool parseBool(const std::string& value, bool& out) {
+    if (value == "1" || value == "true" || value == "on" || value == "yes")       out = true;
+    else if (value == "0" || value == "false" || value == "off" || value == "no") out = false;
+    else return false;
+    return true;
+}
+
+static bool parseCount(const std::string& value, unsigned& out) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) return false;
+    try {
+        unsigned long n = std::stoul(value);
+        if (n == 0 || n > (1u << 20)) return false;
+        out = (unsigned)n;
+        return true;
+    } catch (...) { return false; }
+}
+
+static bool parseLatency(const std::string& value, unsigned& out) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || value.size() > 6) return false;
+    out = (unsigned)std::stoul(value);
+    return out <= 100000;
+}
+
+// field is the part after "icache_" / "dcache_" ("" for the enable flag itself)
+static bool applyCacheOption(CacheConfig& cache, const std::string& field, const std::string& value, bool& known) {
+    known = true;
+    if (field.empty())              return parseBool(value, cache.enabled);
+    if (field == "size")            return parseCount(value, cache.size);
+    if (field == "ways")            return parseCount(value, cache.ways);
+    if (field == "line")            return parseCount(value, cache.line_size);
+    if (field == "policy")          return parseReplacementPolicy(value, cache.policy);
+    if (field == "hit_latency")     return parseLatency(value, cache.hit_latency);
+    if (field == "miss_latency")    return parseLatency(value, cache.miss_latency);
+    if (field == "write") {
+        if (value == "back")         cache.write_back = true;
+        else if (value == "through") cache.write_back = false;
+        else return false;
+        return true;
+    }
+    known = false;
+    return false;
+}
+
+bool applySimulatorOption(SimulatorConfig& config, const std::string& key, const std::string& value, std::string& error) {
+    if (key == "forwarding") {
+        if (parseBool(value, config.forwarding)) return true;
+    } else if (key == "predictor") {
+        if (parsePredictorKind(value, config.predictor)) return true;
+    } else if (key == "bht_entries") {
+        if (parseCount(value, config.bht_entries)) return true;
+    } else if (key == "btb_entries") {
+        if (parseCount(value, config.btb_entries)) return true;
+    } else if (key == "mul_latency") {
+        if (parseCount(value, config.mul_latency)) return true;
+    } else if (key == "div_latency") {
+        if (parseCount(value, config.div_latency)) return true;
+    } else if (key == "icache" || key == "dcache" || key.rfind("icache_", 0) == 0 || key.rfind("dcache_", 0) == 0) {
+        CacheConfig& cache = key[0] == 'i' ? config.icache : config.dcache;
+        bool known = false;
+        if (applyCacheOption(cache, key.size() > 6 ? key.substr(7) : "", value, known)) return true;
+        if (!known) {
+            error = "Unknown simulator option '" + key + "'";
+            return false;
+        }
+    } else {
+        error = "Unknown simulator option '" + key + "'";
+        return false;
+    }
+    error = "Invalid value '" + value + "' for simulator option '" + key + "'";
+    return false;
+}
+
+bool parseSimulatorOptions(const std::string& options, SimulatorConfig& config, std::string& error) {
+    std::stringstream ss(options);
+    std::string item;
+    while (getline(ss, item, ',')) {
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "1" : item.substr(eq + 1);
+        if (!applySimulatorOption(config, key, value, error)) return false;
+    }
+    return validateSimulatorConfig(config, error);
+}
+
+bool validateSimulatorConfig(const SimulatorConfig& config, std::string& error) {
+    if (config.icache.enabled) {
+        std::string problem = validateCacheConfig(config.icache);
+        if (!problem.empty()) { error = "icache: " + problem; return false; }
+    }
+    if (config.dcache.enabled) {
+        std::string problem = validateCacheConfig(config.dcache);
+        if (!problem.empty()) { error = "dcache: " + problem; return false; }
+    }
+    return true;
+}
+
+static void describeCache(std::ostream& ss, const char* name, const CacheConfig& cache) {
+    ss << "," << name << "=" << (cache.enabled ? 1 : 0);
+    if (!cache.enabled) return;
+    ss << "," << name << "_size=" << cache.size
+       << "," << name << "_ways=" << cache.ways
+       << "," << name << "_line=" << cache.line_size
+       << "," << name << "_policy=" << replacementPolicyName(cache.policy)
+       << "," << name << "_write=" << (cache.write_back ? "back" : "through")
+       << "," << name << "_hit_latency=" << cache.hit_latency
+       << "," << name << "_miss_latency=" << cache.miss_latency;
+}
+
+std::string describeSimulatorConfig(const SimulatorConfig& config) {
+    std::ostringstream ss;
+    ss << "forwarding=" << (config.forwarding ? 1 : 0)
+       << ",predictor=" << predictorKindName(config.predictor)
+       << ",bht_entries=" << config.bht_entries
+       << ",btb_entries=" << config.btb_entries
+       << ",mul_latency=" << config.mul_latency
+       << ",div_latency=" << config.div_latency;
+    describeCache(ss, "icache", config.icache);
+    describeCache(ss, "dcache", config.dcache);
+    return ss.str();
+}
@@ -1,22 +1,41 @@
 #include "../hpp_files/simulator.hpp"
+#include "../hpp_files/alu.hpp"
 #include <iostream>
 #include <cstring>
 
-// Opcode Constants
-#define OP_R_TYPE 0x33
-#define OP_I_TYPE 0x13
-#define OP_LW     0x03
-#define OP_SW     0x23
-#define OP_BRANCH 0x63
+// Stage narration for TraceLevel::Full. Only exists in step_impl<true>, so the
+// untraced step_impl<false> carries no formatting code or level checks at all.
+#define TRACE_FULL(msg) \
+    do { if constexpr (Tracing) { if (trace_level == TraceLevel::Full) trace_sink->text() << msg; } } while (0)
 
-RISCV_Simulator::RISCV_Simulator(std::map<unsigned int, unsigned int>& imem) 
-    : inst_memory(imem) 
+RISCV_Simulator::RISCV_Simulator(const std::vector<uint32_t>& code, const SimulatorConfig& cfg)
+    : config(cfg),
+      predictor(cfg.predictor, cfg.bht_entries, cfg.btb_entries),
+      icache(cfg.icache),
+      dcache(cfg.dcache)
 {
+    // Predecode the program into a flat store indexed by word offset
+    program.reserve(code.size());
+    for (uint32_t word : code) program.push_back(decode_instruction(word));
+
     std::memset(registers, 0, sizeof(registers));
-    std::memset(data_memory, 0, sizeof(data_memory));
     pc = INSTRUCTION_MEMORY_START; 
     cycle = 0;
+    std::memset(&counters, 0, sizeof(counters));
     stall_pipeline = false;
+    scoreboard.clear();
+    fetch_pc = 0;
+    fetch_pending = false;
+    fetch_wait = 0;
+    mem_pending = false;
+    mem_wait = 0;
+    ex_pending = false;
+    ex_wait = 0;
+    snapshot_interval = 0;
+    max_snapshots = 0;
+    recording = nullptr;
+    trace_level = TraceLevel::Full;
+    trace_sink = &consoleTraceSink();
     
     std::memset(&if_id, 0, sizeof(if_id));
     std::memset(&id_ex, 0, sizeof(id_ex));
@@ -29,38 +48,131 @@ RISCV_Simulator::RISCV_Simulator(std::map<unsigned int, unsigned int>& imem)
     mem_wb_next = mem_wb;
 }
 
-int32_t RISCV_Simulator::sign_extend(uint32_t inst, int type) {
-    int32_t value = 0;
-    if (type == 0) { // I-type
-        value = (inst >> 20);
-        if (value & 0x800) value |= 0xFFFFF000;
-    } else if (type == 1) { // S-type
-        value = ((inst >> 25) << 5) | ((inst >> 7) & 0x1F);
-        if (value & 0x800) value |= 0xFFFFF000;
-    } else if (type == 2) { // B-type
-        value = ((inst >> 31) << 12) | ((inst & 0x7E000000) >> 20) | ((inst & 0xF00) >> 8) | ((inst & 0x80) >> 7); 
-        value = (value << 19) >> 19;
-    }
-    return value;
+RISCV_Simulator::Snapshot RISCV_Simulator::snapshot() const {
+    Snapshot snap;
+    std::memcpy(snap.registers, registers, sizeof(registers));
+    snap.memory = data_memory.snapshot();
+    snap.pc = pc;
+    snap.cycle = cycle;
+    snap.counters = counters;
+    snap.stall_pipeline = stall_pipeline;
+    snap.scoreboard = scoreboard;
+    snap.predictor = predictor;
+    snap.icache = icache;
+    snap.dcache = dcache;
+    snap.fetch_pc = fetch_pc;
+    snap.fetch_pending = fetch_pending;
+    snap.fetch_wait = fetch_wait;
+    snap.mem_pending = mem_pending;
+    snap.mem_wait = mem_wait;
+    snap.ex_pending = ex_pending;
+    snap.ex_wait = ex_wait;
+    snap.if_id = if_id;   snap.if_id_next = if_id_next;
+    snap.id_ex = id_ex;   snap.id_ex_next = id_ex_next;
+    snap.ex_mem = ex_mem; snap.ex_mem_next = ex_mem_next;
+    snap.mem_wb = mem_wb; snap.mem_wb_next = mem_wb_next;
+    return snap;
+}
+
+void RISCV_Simulator::restore(const Snapshot& snap) {
+    restore_state(snap);
+    if (history_enabled()) reset_history();
+}
+
+void RISCV_Simulator::restore_state(const Snapshot& snap) {
+    std::memcpy(registers, snap.registers, sizeof(registers));
+    data_memory.restore(snap.memory);
+    pc = snap.pc;
+    cycle = snap.cycle;
+    counters = snap.counters;
+    stall_pipeline = snap.stall_pipeline;
+    scoreboard = snap.scoreboard;
+    predictor = snap.predictor;
+    icache = snap.icache;
+    dcache = snap.dcache;
+    fetch_pc = snap.fetch_pc;
+    fetch_pending = snap.fetch_pending;
+    fetch_wait = snap.fetch_wait;
+    mem_pending = snap.mem_pending;
+    mem_wait = snap.mem_wait;
+    ex_pending = snap.ex_pending;
+    ex_wait = snap.ex_wait;
+    if_id = snap.if_id;   if_id_next = snap.if_id_next;
+    id_ex = snap.id_ex;   id_ex_next = snap.id_ex_next;
+    ex_mem = snap.ex_mem; ex_mem_next = snap.ex_mem_next;
+    mem_wb = snap.mem_wb; mem_wb_next = snap.mem_wb_next;
+}
+
+void RISCV_Simulator::set_trace(TraceLevel level, TraceSink* sink) {
+    trace_level = level;
+    trace_sink = sink ? sink : &consoleTraceSink();
 }
 
 void RISCV_Simulator::step() {
+    if (history_enabled()) {
+        step_recorded();
+        return;
+    }
+    if (trace_level == TraceLevel::Off) step_impl<false>();
+    else step_impl<true>();
+}
+
+uint64_t RISCV_Simulator::run(uint64_t max_cycles) {
+    uint64_t count = 0;
+    while ((max_cycles == 0 || count < max_cycles) && !is_halted()) {
+        step();
+        count++;
+    }
+    return count;
+}
+
+template <bool Tracing>
+void RISCV_Simulator::step_impl() {
     cycle++;
     
-    std::cout << "\n========== CYCLE " << cycle << " ==========\n";
+    TRACE_FULL("\n========== CYCLE " << cycle << " ==========\n");
+
+    // =================================================================
+    // D-CACHE: while a load/store in MEM waits, the whole pipeline freezes
+    // =================================================================
+    if (dcache.enabled() && ex_mem.IR != 0 && (ex_mem.MemRead || ex_mem.MemWrite)) {
+        if (!mem_pending) {
+            mem_wait = dcache.access((uint32_t)ex_mem.ALUOutput, ex_mem.MemWrite, recording ? &recording->dcache : nullptr) - 1;
+            mem_pending = true;
+        }
+        if (mem_wait > 0) {
+            mem_wait--;
+            counters.dcache_stall_cycles++;
+            if (fetch_wait > 0) fetch_wait--; // An I-cache fill in flight keeps going
+            TRACE_FULL("[MEM] Waiting on D-cache, pipeline frozen (" << mem_wait << " more cycles)\n");
+
+            if constexpr (Tracing) {
+                CycleTrace trace = { cycle, pc, if_id.IR, id_ex.IR, ex_mem.IR, mem_wb.IR,
+                                     false, false, false, false, true };
+                trace_sink->end_cycle(trace_level, trace);
+            }
+            return;
+        }
+        mem_pending = false;
+    }
 
     // =================================================================
     // 1. WRITE BACK (WB) STAGE
     // =================================================================
     if (mem_wb.RegWrite && mem_wb.rd != 0) {
-        int32_t data = (mem_wb.IR & 0x7F) == OP_LW ? mem_wb.LMD : mem_wb.ALUOutput;
+        int32_t data = (mem_wb.IR & 0x7F) == OP_LOAD ? mem_wb.LMD : mem_wb.ALUOutput;
+        if (recording) {
+            recording->reg = (int8_t)mem_wb.rd;
+            recording->reg_old = registers[mem_wb.rd];
+        }
         registers[mem_wb.rd] = data;
         registers[0] = 0; // Hardwire x0
         
-        std::cout << "[WB] Wrote " << data << " to x" << (int)mem_wb.rd << "\n";
+        TRACE_FULL("[WB] Wrote " << data << " to x" << (int)mem_wb.rd << "\n");
     } else if (mem_wb.IR != 0) {
-        std::cout << "[WB] No write back (NOP or x0)\n";
+        TRACE_FULL("[WB] No write back (NOP or x0)\n");
     }
+    if (mem_wb.IR != 0) counters.instret++;
 
     // =================================================================
     // 2. MEMORY (MEM) STAGE
@@ -72,40 +184,32 @@ void RISCV_Simulator::step() {
     mem_wb_next.LMD = 0;
 
     if (ex_mem.IR != 0) {
-        // HANDLE LOAD WORD (Read 4 Bytes)
+        if (ex_mem.MemRead) counters.loads++;
+        if (ex_mem.MemWrite) counters.stores++;
+
+        // HANDLE LOADS (1, 2 or 4 bytes, extended to 32 bits)
         if (ex_mem.MemRead) { 
-            if (ex_mem.ALUOutput >= 0 && ex_mem.ALUOutput <= 124) {
-                uint32_t b0 = data_memory[ex_mem.ALUOutput];
-                uint32_t b1 = data_memory[ex_mem.ALUOutput + 1];
-                uint32_t b2 = data_memory[ex_mem.ALUOutput + 2];
-                uint32_t b3 = data_memory[ex_mem.ALUOutput + 3];
-                
-                mem_wb_next.LMD = b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
-                
-                std::cout << "[MEM] LW: Read " << mem_wb_next.LMD << " from addr " << ex_mem.ALUOutput << "\n";
-            } else {
-                std::cout << "[MEM] LW ERROR: Address " << ex_mem.ALUOutput << " out of bounds\n";
-            }
+            static const char* const names[8] = { "LB", "LH", "LW", "LW", "LBU", "LHU", "LW", "LW" };
+            uint32_t addr = (uint32_t)ex_mem.ALUOutput;
+            mem_wb_next.LMD = load_value(ex_mem.func3, data_memory, addr);
+            TRACE_FULL("[MEM] " << names[ex_mem.func3] << ": Read " << mem_wb_next.LMD << " from addr " << addr << "\n");
         }
         
-        // HANDLE STORE WORD (Write 4 Bytes)
+        // HANDLE STORES (the low 1, 2 or 4 bytes of B)
         if (ex_mem.MemWrite) { 
-            if (ex_mem.ALUOutput >= 0 && ex_mem.ALUOutput <= 124) {
-                uint32_t val = ex_mem.B;
-                
-                data_memory[ex_mem.ALUOutput]     = val & 0xFF;
-                data_memory[ex_mem.ALUOutput + 1] = (val >> 8) & 0xFF;
-                data_memory[ex_mem.ALUOutput + 2] = (val >> 16) & 0xFF;
-                data_memory[ex_mem.ALUOutput + 3] = (val >> 24) & 0xFF;
-                
-                std::cout << "[MEM] SW: Wrote " << val << " to addr " << ex_mem.ALUOutput << "\n";
-            } else {
-                std::cout << "[MEM] SW ERROR: Address " << ex_mem.ALUOutput << " out of bounds\n";
+            static const char* const names[8] = { "SB", "SH", "SW", "SW", "SW", "SW", "SW", "SW" };
+            uint32_t addr = (uint32_t)ex_mem.ALUOutput;
+            if (recording) {
+                recording->mem_written = true;
+                recording->mem_addr = addr;
+                recording->mem_old = data_memory.read32(addr);
             }
+            store_value(ex_mem.func3, data_memory, addr, ex_mem.B);
+            TRACE_FULL("[MEM] " << names[ex_mem.func3] << ": Wrote " << ex_mem.B << " to addr " << addr << "\n");
         }
         
         if (!ex_mem.MemRead && !ex_mem.MemWrite) {
-            std::cout << "[MEM] No memory operation\n";
+            TRACE_FULL("[MEM] No memory operation\n");
         }
     }
 
@@ -118,191 +222,317 @@ void RISCV_Simulator::step() {
     ex_mem_next.RegWrite = id_ex.RegWrite;
     ex_mem_next.MemRead = id_ex.MemRead;
     ex_mem_next.MemWrite = id_ex.MemWrite;
-    ex_mem_next.Branch = id_ex.Branch;
+    ex_mem_next.Branch = id_ex.Branch || id_ex.Jump;
     ex_mem_next.cond = false;
+    ex_mem_next.func3 = id_ex.func3;
     ex_mem_next.ALUOutput = 0;
+    uint32_t target = 0; // Where a taken branch or a jump goes
+
+    // A multi-cycle operation keeps its instruction in ID/EX until the last cycle
+    bool ex_busy = false;
+    if (id_ex.IR != 0 && ex_occupancy(id_ex) > 1) {
+        if (!ex_pending) {
+            ex_wait = ex_occupancy(id_ex) - 1;
+            ex_pending = true;
+        }
+        if (ex_wait > 0) {
+            ex_wait--;
+            ex_busy = true;
+        } else {
+            ex_pending = false;
+        }
+    }
 
     if (id_ex.IR != 0) {
-        int32_t op1 = id_ex.A;
-        int32_t op2 = (id_ex.opcode == OP_I_TYPE || id_ex.opcode == OP_LW || id_ex.opcode == OP_SW) ? id_ex.IMM : id_ex.B;
-        
-        std::cout << "[EX] Opcode=0x" << std::hex << (int)id_ex.opcode << std::dec;
-        
-        if (id_ex.opcode == OP_R_TYPE) {
-            if (id_ex.func3 == 0x0) { // ADD, SUB
-                if (id_ex.func7 == 0x20) {
-                    ex_mem_next.ALUOutput = op1 - op2;
-                    std::cout << " SUB: " << op1 << " - " << op2 << " = " << ex_mem_next.ALUOutput << "\n";
-                } else {
-                    ex_mem_next.ALUOutput = op1 + op2;
-                    std::cout << " ADD: " << op1 << " + " << op2 << " = " << ex_mem_next.ALUOutput << "\n";
-                }
+        int32_t a = id_ex.A;
+        int32_t b = id_ex.B;
+
+        // =================================================================
+        // FORWARDING UNIT: EX/MEM -> EX and MEM/WB -> EX
+        // =================================================================
+        // EX/MEM wins over MEM/WB (it holds the newer value). A load in EX/MEM has
+        // no data yet; the ID stage stalls load-use pairs so that never happens.
+        if (config.forwarding) {
+            bool from_ex_mem = ex_mem.RegWrite && !ex_mem.MemRead && ex_mem.rd != 0;
+            bool from_mem_wb = mem_wb.RegWrite && mem_wb.rd != 0;
+            int32_t mem_wb_value = (mem_wb.IR & 0x7F) == OP_LOAD ? mem_wb.LMD : mem_wb.ALUOutput;
+
+            if (from_ex_mem && ex_mem.rd == id_ex.rs1) {
+                a = ex_mem.ALUOutput;
+                TRACE_FULL("[FWD] EX/MEM -> A (x" << (int)id_ex.rs1 << " = " << a << ")\n");
+            } else if (from_mem_wb && mem_wb.rd == id_ex.rs1) {
+                a = mem_wb_value;
+                TRACE_FULL("[FWD] MEM/WB -> A (x" << (int)id_ex.rs1 << " = " << a << ")\n");
             }
-            else if (id_ex.func3 == 0x1) {
-                ex_mem_next.ALUOutput = op1 << (op2 & 0x1F);
-                std::cout << " SLL: " << op1 << " << " << (op2 & 0x1F) << " = " << ex_mem_next.ALUOutput << "\n";
+
+            if (from_ex_mem && ex_mem.rd == id_ex.rs2) {
+                b = ex_mem.ALUOutput;
+                TRACE_FULL("[FWD] EX/MEM -> B (x" << (int)id_ex.rs2 << " = " << b << ")\n");
+            } else if (from_mem_wb && mem_wb.rd == id_ex.rs2) {
+                b = mem_wb_value;
+                TRACE_FULL("[FWD] MEM/WB -> B (x" << (int)id_ex.rs2 << " = " << b << ")\n");
             }
-            else if (id_ex.func3 == 0x2) {
-                ex_mem_next.ALUOutput = (op1 < op2) ? 1 : 0;
-                std::cout << " SLT: " << op1 << " < " << op2 << " = " << ex_mem_next.ALUOutput << "\n";
+            ex_mem_next.B = b; // SW stores the forwarded value
+        }
+
+        int32_t op1 = a;
+        int32_t op2 = (id_ex.opcode == OP_R_TYPE || id_ex.opcode == OP_BRANCH) ? b : id_ex.IMM;
+        uint32_t inst_pc = id_ex.NPC - 4;
+        
+        TRACE_FULL("[EX] Opcode=0x" << std::hex << (int)id_ex.opcode << std::dec);
+        
+        if (ex_busy) {
+            // Keep the operands (a forwarded value leaves its latch meanwhile) and send MEM a bubble
+            id_ex_next.A = a;
+            id_ex_next.B = b;
+            std::memset(&ex_mem_next, 0, sizeof(ex_mem_next));
+            counters.bubbles++;
+            TRACE_FULL(" busy (" << ex_wait << " more cycles)\n");
+        }
+        else if (is_muldiv(id_ex)) {
+            static const char* const names[8] = { "MUL", "MULH", "MULHSU", "MULHU", "DIV", "DIVU", "REM", "REMU" };
+            ex_mem_next.ALUOutput = muldiv_result(id_ex.func3, op1, op2);
+            counters.muldiv++;
+            TRACE_FULL(" " << names[id_ex.func3] << ": " << op1 << ", " << op2 << " = " << ex_mem_next.ALUOutput << "\n");
+        }
+        else if (id_ex.opcode == OP_R_TYPE || id_ex.opcode == OP_I_TYPE) {
+            static const char* const names[2][8] = {
+                { "ADD", "SLL", "SLT", "SLTU", "XOR", "SRL", "OR", "AND" },
+                { "ADDI", "SLLI", "SLTI", "SLTIU", "XORI", "SRLI", "ORI", "ANDI" },
+            };
+            static const char* const symbols[8] = { "+", "<<", "<", "<", "^", ">>", "|", "&" };
+            bool imm = id_ex.opcode == OP_I_TYPE;
+            // SUB is R-type only; SRA and SRAI share their funct7 with it
+            bool alt = id_ex.func7 == 0x20 && (id_ex.func3 == 0x5 || (!imm && id_ex.func3 == 0x0));
+            ex_mem_next.ALUOutput = alu_result(id_ex.func3, alt, op1, op2);
+
+            const char* name = alt ? (id_ex.func3 == 0x0 ? "SUB" : imm ? "SRAI" : "SRA") : names[imm][id_ex.func3];
+            const char* symbol = alt && id_ex.func3 == 0x0 ? "-" : symbols[id_ex.func3];
+            TRACE_FULL(" " << name << ": ");
+            if (id_ex.func3 == 0x1 || id_ex.func3 == 0x5) {
+                TRACE_FULL(op1 << " " << symbol << " " << (op2 & 0x1F));
+            } else if (id_ex.func3 == 0x3) {
+                TRACE_FULL((uint32_t)op1 << " " << symbol << " " << (uint32_t)op2);
+            } else {
+                TRACE_FULL(op1 << " " << symbol << " " << op2);
             }
-        } 
-        else if (id_ex.opcode == OP_I_TYPE) {
-             if (id_ex.func3 == 0x0) {
-                 ex_mem_next.ALUOutput = op1 + op2;
-                 std::cout << " ADDI: " << op1 << " + " << op2 << " = " << ex_mem_next.ALUOutput << "\n";
-             }
-             else if (id_ex.func3 == 0x1) {
-                 ex_mem_next.ALUOutput = op1 << (op2 & 0x1F);
-                 std::cout << " SLLI: " << op1 << " << " << (op2 & 0x1F) << " = " << ex_mem_next.ALUOutput << "\n";
-             }
+            TRACE_FULL(" = " << ex_mem_next.ALUOutput << "\n");
         }
-        else if (id_ex.opcode == OP_LW || id_ex.opcode == OP_SW) {
+        else if (id_ex.opcode == OP_LOAD || id_ex.opcode == OP_STORE) {
             ex_mem_next.ALUOutput = op1 + op2;
-            std::cout << " ADDR: " << op1 << " + " << op2 << " = " << ex_mem_next.ALUOutput << "\n";
+            TRACE_FULL(" ADDR: " << op1 << " + " << op2 << " = " << ex_mem_next.ALUOutput << "\n");
+        }
+        else if (id_ex.opcode == OP_LUI) {
+            ex_mem_next.ALUOutput = op2;
+            TRACE_FULL(" LUI: " << op2 << "\n");
+        }
+        else if (id_ex.opcode == OP_AUIPC) {
+            ex_mem_next.ALUOutput = (int32_t)(inst_pc + (uint32_t)op2);
+            TRACE_FULL(" AUIPC: 0x" << std::hex << inst_pc << std::dec << " + " << op2 << " = " << ex_mem_next.ALUOutput << "\n");
+        }
+        else if (id_ex.Jump) {
+            // The link is the address after the jump; JALR clears bit 0 of its target
+            target = id_ex.opcode == OP_JALR ? ((uint32_t)op1 + (uint32_t)op2) & ~1u : inst_pc + (uint32_t)op2;
+            ex_mem_next.ALUOutput = (int32_t)id_ex.NPC;
+            ex_mem_next.cond = true;
+            TRACE_FULL(" " << (id_ex.opcode == OP_JALR ? "JALR" : "JAL") << ": target 0x" << std::hex << target
+                      << ", link 0x" << id_ex.NPC << std::dec << "\n");
         }
         else if (id_ex.opcode == OP_BRANCH) {
-            if (id_ex.func3 == 0x0) {
-                ex_mem_next.cond = (op1 == op2);
-                std::cout << " BEQ: " << op1 << " == " << op2 << " ? " << ex_mem_next.cond << "\n";
-            }
-            else if (id_ex.func3 == 0x4) {
-                ex_mem_next.cond = (op1 < op2);
-                std::cout << " BLT: " << op1 << " < " << op2 << " ? " << ex_mem_next.cond << "\n";
+            static const char* const names[8] = { "BEQ", "BNE", nullptr, nullptr, "BLT", "BGE", "BLTU", "BGEU" };
+            static const char* const symbols[8] = { "==", "!=", nullptr, nullptr, "<", ">=", "<", ">=" };
+            ex_mem_next.cond = branch_condition(id_ex.func3, op1, op2);
+            target = inst_pc + (uint32_t)id_ex.IMM;
+            if (!names[id_ex.func3]) {
+                TRACE_FULL(" Reserved branch encoding, never taken\n");
+            } else if (id_ex.func3 >= 0x6) {
+                TRACE_FULL(" " << names[id_ex.func3] << ": " << (uint32_t)op1 << " " << symbols[id_ex.func3] << " "
+                          << (uint32_t)op2 << " ? " << ex_mem_next.cond << "\n");
+            } else {
+                TRACE_FULL(" " << names[id_ex.func3] << ": " << op1 << " " << symbols[id_ex.func3] << " "
+                          << op2 << " ? " << ex_mem_next.cond << "\n");
             }
         }
     }
 
     // =================================================================
-    // CONTROL HAZARD: Pipeline Freeze on Branch Taken
+    // CONTROL HAZARD: Resolve branch or jump, flush on misprediction
     // =================================================================
-    bool branch_taken = ex_mem_next.Branch && ex_mem_next.cond;
-    if (branch_taken) {
-        // Calculate branch target
-        uint32_t branch_target = id_ex.NPC + (id_ex.IMM << 1) - 4;
-        pc = branch_target;
-        
-        std::cout << "[CONTROL HAZARD] Branch taken! Flushing IF/ID and ID/EX. New PC: 0x" 
-                  << std::hex << pc << std::dec << "\n";
-        
-        // Flush the two instructions that were incorrectly fetched
-        std::memset(&if_id_next, 0, sizeof(if_id_next));
-        std::memset(&id_ex_next, 0, sizeof(id_ex_next));
-        stall_pipeline = true; 
+    bool mispredicted = false;
+    if (ex_mem_next.Branch) {
+        bool taken = ex_mem_next.cond;
+        uint32_t branch_pc = id_ex.NPC - 4;
+        uint32_t branch_target = target;
+
+        mispredicted = (taken != id_ex.PredTaken) || (taken && id_ex.PredTarget != branch_target);
+        predictor.update(branch_pc, taken, branch_target, mispredicted, recording ? &recording->predictor : nullptr);
+        if (recording) recording->branch_resolved = true;
+        counters.branches++;
+
+        if (mispredicted) {
+            pc = taken ? branch_target : id_ex.NPC;
+
+            TRACE_FULL("[CONTROL HAZARD] " << (id_ex.Jump ? "Jump " : "Branch ") << (taken ? "taken" : "not taken")
+                      << " (predicted " << (id_ex.PredTaken ? "taken" : "not taken")
+                      << ")! Flushing IF/ID and ID/EX. New PC: 0x" << std::hex << pc << std::dec << "\n");
+
+            // Flush the two instructions that were incorrectly fetched
+            std::memset(&if_id_next, 0, sizeof(if_id_next));
+            std::memset(&id_ex_next, 0, sizeof(id_ex_next));
+            stall_pipeline = true;
+            counters.control_flushes++;
+            counters.bubbles += 2;
+        } else {
+            TRACE_FULL("[BRANCH] Predicted correctly (" << (taken ? "taken" : "not taken") << ")\n");
+        }
     }
+    bool flushed = mispredicted;
 
     // =================================================================
-    // 4. DECODE (ID) STAGE - DATA HAZARD DETECTION (NO FORWARDING)
+    // 4. DECODE (ID) STAGE - DATA HAZARD DETECTION
     // =================================================================
-    id_ex_next.IR = if_id.IR;
-    id_ex_next.NPC = if_id.NPC;
-    
+    // On a taken branch ID/EX was already flushed above; the instruction in
+    // IF/ID is discarded rather than passed on as an undecoded IR.
     bool data_hazard_detected = false;
     
-    if (if_id.IR != 0 && !stall_pipeline) {
-        uint32_t inst = if_id.IR;
-        id_ex_next.opcode = inst & 0x7F;
-        id_ex_next.rd = (inst >> 7) & 0x1F;
-        id_ex_next.func3 = (inst >> 12) & 0x07;
-        uint8_t rs1 = (inst >> 15) & 0x1F;
-        uint8_t rs2 = (inst >> 20) & 0x1F;
-        id_ex_next.func7 = (inst >> 25) & 0x7F;
-
-        id_ex_next.rs1 = rs1;
-        id_ex_next.rs2 = rs2;
-
-        // Set control signals
-        id_ex_next.RegWrite = (id_ex_next.opcode == OP_R_TYPE || id_ex_next.opcode == OP_I_TYPE || id_ex_next.opcode == OP_LW);
-        id_ex_next.MemRead  = (id_ex_next.opcode == OP_LW);
-        id_ex_next.MemWrite = (id_ex_next.opcode == OP_SW);
-        id_ex_next.Branch   = (id_ex_next.opcode == OP_BRANCH);
-
-        // Sign extend immediate
-        if (id_ex_next.opcode == OP_I_TYPE || id_ex_next.opcode == OP_LW) {
-            id_ex_next.IMM = sign_extend(inst, 0);
-        }
-        else if (id_ex_next.opcode == OP_SW) {
-            id_ex_next.IMM = sign_extend(inst, 1);
-        }
-        else if (id_ex_next.opcode == OP_BRANCH) {
-            id_ex_next.IMM = sign_extend(inst, 2);
-        }
-        else {
-            id_ex_next.IMM = 0;
+    if (ex_busy) {
+        // ID/EX cannot move on: hold it and IF/ID
+        TRACE_FULL("[ID] Waiting on EX\n");
+        stall_pipeline = true;
+        counters.ex_busy_stalls++;
+    } else if (if_id.IR != 0 && !stall_pipeline) {
+        // Decoding is a copy of the control fields predecoded at load, unless the
+        // slot was rewritten (set_instruction) after IF latched it: then the word
+        // that was fetched is decoded here
+        const DecodedInst* slot = program_slot(if_id.PC);
+        DecodedInst fetched;
+        if (!slot || slot->ctrl.IR != if_id.IR) {
+            fetched = decode_instruction(if_id.IR);
+            slot = &fetched;
         }
+        const DecodedInst& decoded = *slot;
+        uint32_t inst = if_id.IR;
+        uint8_t rs1 = decoded.ctrl.rs1;
+        uint8_t rs2 = decoded.ctrl.rs2;
+        id_ex_next = decoded.ctrl;
+        id_ex_next.NPC = if_id.NPC;
+        id_ex_next.PredTaken = if_id.PredTaken;
+        id_ex_next.PredTarget = if_id.PredTarget;
 
         // =================================================================
-        // DATA HAZARD DETECTION: NO FORWARDING - Must stall until data is written back
+        // DATA HAZARD DETECTION
+        // A source register stalls ID until the scoreboard says its value can
+        // be used: after write back without forwarding, otherwise once the
+        // producer's result latency has passed (a load's is one cycle past
+        // EX: load-use; a multiply's or divide's is set in the config).
         // =================================================================
-        // Check if current instruction needs rs1 or rs2
-        bool needs_rs1 = (id_ex_next.opcode == OP_R_TYPE || id_ex_next.opcode == OP_I_TYPE || 
-                          id_ex_next.opcode == OP_LW || id_ex_next.opcode == OP_SW || 
-                          id_ex_next.opcode == OP_BRANCH);
-        bool needs_rs2 = (id_ex_next.opcode == OP_R_TYPE || id_ex_next.opcode == OP_SW || 
-                          id_ex_next.opcode == OP_BRANCH);
-
-        std::cout << "[ID] Decoding IR=0x" << std::hex << inst << std::dec 
-                  << " rs1=x" << (int)rs1 << " rs2=x" << (int)rs2 << "\n";
-
-        // Check for RAW hazards in EX stage (1 cycle away)
-        if (id_ex.RegWrite && id_ex.rd != 0) {
-            if ((needs_rs1 && id_ex.rd == rs1) || (needs_rs2 && id_ex.rd == rs2)) {
-                data_hazard_detected = true;
-                std::cout << "[DATA HAZARD] RAW detected with EX stage (rd=x" << (int)id_ex.rd << ")\n";
-            }
-        }
+        bool needs_rs1 = decoded.needs_rs1;
+        bool needs_rs2 = decoded.needs_rs2;
+        uint64_t now = pipeline_clock();
 
-        // Check for RAW hazards in MEM stage (2 cycles away)
-        if (ex_mem.RegWrite && ex_mem.rd != 0) {
-            if ((needs_rs1 && ex_mem.rd == rs1) || (needs_rs2 && ex_mem.rd == rs2)) {
-                data_hazard_detected = true;
-                std::cout << "[DATA HAZARD] RAW detected with MEM stage (rd=x" << (int)ex_mem.rd << ")\n";
-            }
-        }
+        TRACE_FULL("[ID] Decoding IR=0x" << std::hex << inst << std::dec 
+                  << " rs1=x" << (int)rs1 << " rs2=x" << (int)rs2 << "\n");
+
+        bool stall_rs1 = needs_rs1 && scoreboard.busy(rs1, now);
+        bool stall_rs2 = needs_rs2 && scoreboard.busy(rs2, now) && !(stall_rs1 && rs1 == rs2);
+        if (stall_rs1 || stall_rs2) {
+            data_hazard_detected = true;
 
-        // Check for RAW hazards in WB stage (3 cycles away)
-        if (mem_wb.RegWrite && mem_wb.rd != 0) {
-            if ((needs_rs1 && mem_wb.rd == rs1) || (needs_rs2 && mem_wb.rd == rs2)) {
-                data_hazard_detected = true;
-                std::cout << "[DATA HAZARD] RAW detected with WB stage (rd=x" << (int)mem_wb.rd << ")\n";
+            // Attributed to the nearest producer: the one furthest from WB
+            uint64_t wb1 = stall_rs1 ? scoreboard[rs1].wb : 0;
+            uint64_t wb2 = stall_rs2 ? scoreboard[rs2].wb : 0;
+            uint64_t until_wb = (wb1 > wb2 ? wb1 : wb2) - now;
+            if (until_wb >= 2) counters.raw_stalls_ex++;
+            else if (until_wb == 1) counters.raw_stalls_mem++;
+            else counters.raw_stalls_wb++;
+
+            if constexpr (Tracing) {
+                auto report = [&](uint8_t reg) {
+                    uint64_t distance = scoreboard[reg].wb - now;
+                    const char* stage = distance >= 2 ? "EX" : distance == 1 ? "MEM" : "WB";
+                    TRACE_FULL("[DATA HAZARD] " << (config.forwarding ? "Load-use with " : "RAW detected with ")
+                              << stage << " stage (rd=x" << (int)reg << ")\n");
+                };
+                // Nearest producer first
+                if (stall_rs1 && wb1 >= wb2) report(rs1);
+                if (stall_rs2) report(rs2);
+                if (stall_rs1 && wb1 < wb2) report(rs1);
             }
         }
 
         // If hazard detected, insert bubble (NOP) and stall
         if (data_hazard_detected) {
-            std::cout << "[STALL] Inserting bubble, keeping IF/ID unchanged\n";
+            TRACE_FULL("[STALL] Inserting bubble, keeping IF/ID unchanged\n");
             std::memset(&id_ex_next, 0, sizeof(id_ex_next)); // Insert NOP
             if_id_next = if_id; // Keep IF/ID unchanged
             stall_pipeline = true;
+            counters.bubbles++;
         } else {
             // No hazard, read register values
             id_ex_next.A = registers[rs1];
             id_ex_next.B = registers[rs2];
-            std::cout << "[ID] Read A=x" << (int)rs1 << "=" << id_ex_next.A 
-                      << ", B=x" << (int)rs2 << "=" << id_ex_next.B << "\n";
+            if (id_ex_next.RegWrite && id_ex_next.rd != 0) {
+                // In EX from next cycle, then MEM, then WB
+                uint64_t wb = now + ex_occupancy(id_ex_next) + 2;
+                uint64_t ready = config.forwarding ? now + result_latency(id_ex_next) : wb + 1;
+                if (recording) {
+                    recording->scoreboard_reg = (int8_t)id_ex_next.rd;
+                    recording->scoreboard_old = scoreboard[id_ex_next.rd];
+                }
+                scoreboard.issue(id_ex_next.rd, ready, wb);
+            }
+            TRACE_FULL("[ID] Read A=x" << (int)rs1 << "=" << id_ex_next.A 
+                      << ", B=x" << (int)rs2 << "=" << id_ex_next.B << "\n");
         }
     } else if (if_id.IR == 0) {
-        std::cout << "[ID] Bubble (NOP)\n";
+        TRACE_FULL("[ID] Bubble (NOP)\n");
         std::memset(&id_ex_next, 0, sizeof(id_ex_next));
     }
 
     // =================================================================
     // 5. FETCH (IF) STAGE
     // =================================================================
+    bool icache_waiting = false;
     if (!stall_pipeline) {
-        if (inst_memory.count(pc)) {
-            if_id_next.IR = inst_memory[pc];
+        const DecodedInst* slot = program_slot(pc);
+        if (slot && icache.enabled() && (!fetch_pending || fetch_pc != pc)) {
+            // New fetch (a redirect abandons the one in flight)
+            fetch_wait = icache.access(pc, false, recording ? &recording->icache : nullptr) - 1;
+            fetch_pending = true;
+            fetch_pc = pc;
+        }
+
+        if (slot && fetch_wait > 0) {
+            fetch_wait--;
+            icache_waiting = true;
+            counters.icache_stall_cycles++;
+            std::memset(&if_id_next, 0, sizeof(if_id_next));
+            TRACE_FULL("[IF] Waiting on I-cache for PC=0x" << std::hex << pc << std::dec
+                      << " (" << fetch_wait << " more cycles)\n");
+        } else if (slot) {
+            fetch_pending = false;
+            if_id_next.IR = slot->ctrl.IR;
             if_id_next.PC = pc;
             if_id_next.NPC = pc + 4;
-            std::cout << "[IF] Fetched IR=0x" << std::hex << if_id_next.IR << " from PC=0x" << pc << std::dec << "\n";
-            pc += 4;
+            TRACE_FULL("[IF] Fetched IR=0x" << std::hex << if_id_next.IR << " from PC=0x" << pc << std::dec << "\n");
+
+            BranchPrediction prediction = predictor.predict(pc, *slot);
+            if_id_next.PredTaken = prediction.taken;
+            if_id_next.PredTarget = prediction.target;
+            if (prediction.taken) {
+                pc = prediction.target;
+                TRACE_FULL("[IF] Predicted taken, next PC=0x" << std::hex << pc << std::dec << "\n");
+            } else {
+                pc += 4;
+            }
         } else {
-            std::cout << "[IF] No instruction at PC=0x" << std::hex << pc << std::dec << " (End of program)\n";
+            TRACE_FULL("[IF] No instruction at PC=0x" << std::hex << pc << std::dec << " (End of program)\n");
             if_id_next.IR = 0;
         }
     } else {
-        std::cout << "[IF] Pipeline stalled (not fetching)\n";
+        TRACE_FULL("[IF] Pipeline stalled (not fetching)\n");
         stall_pipeline = false; // Reset stall flag for next cycle
+        if (fetch_wait > 0) fetch_wait--; // An I-cache fill in flight keeps going
     }
 
     // =================================================================
@@ -313,5 +543,236 @@ void RISCV_Simulator::step() {
     id_ex  = id_ex_next;
     if_id  = if_id_next;
     
-    std::cout << "========================================\n";
-}
\ No newline at end of file
+    TRACE_FULL("========================================\n");
+
+    if constexpr (Tracing) {
+        CycleTrace trace = { cycle, pc, if_id.IR, id_ex.IR, ex_mem.IR, mem_wb.IR,
+                             data_hazard_detected, ex_busy, flushed, icache_waiting, false };
+        trace_sink->end_cycle(trace_level, trace);
+    }
+}
+
+// =====================================================================
+// FUNCTIONAL (ISA-LEVEL) EXECUTION
+// =====================================================================
+// Executes the instruction at pc to completion with no pipeline timing. The
+// results match what the pipeline produces when the same instruction retires.
+bool RISCV_Simulator::step_functional() {
+    const DecodedInst* slot = program_slot(pc);
+    if (!slot) return false;
+    if (history_enabled()) reset_history();
+
+    const ID_EX& c = slot->ctrl;
+    if (c.Branch || c.Jump) {
+        // JALR reads rs1 before the link is written (rd may be rs1)
+        uint32_t target = c.opcode == OP_JALR ? ((uint32_t)registers[c.rs1] + c.IMM) & ~1u : pc + c.IMM;
+        if (c.Jump && c.rd != 0) registers[c.rd] = (int32_t)(pc + 4);
+        pc = branch_taken(branch_kind(c), registers[c.rs1], registers[c.rs2]) ? target : pc + 4;
+    } else {
+        ThreadedOp op = translate_op(c, pc);
+        if (op.exec) op.exec(op, registers, data_memory);
+        pc += 4;
+    }
+    counters.instret++;
+    return true;
+}
+
+uint64_t RISCV_Simulator::run_functional(uint64_t max_instructions) {
+    return run_blocks<false>(max_instructions);
+}
+
+uint64_t RISCV_Simulator::run_jit(uint64_t max_instructions) {
+    return run_blocks<true>(max_instructions);
+}
+
+template <bool Native>
+uint64_t RISCV_Simulator::run_blocks(uint64_t max_instructions) {
+    if (history_enabled()) reset_history();
+
+    uint64_t count = 0;
+    TranslatedBlock* block = block_cache.lookup(program, INSTRUCTION_MEMORY_START, pc);
+    while (block) {
+        // A block runs whole; whatever is left of the limit goes one instruction at a time
+        if (max_instructions != 0 && max_instructions - count < block->length) {
+            counters.instret += count;
+            while (count < max_instructions && step_functional()) count++;
+            return count;
+        }
+
+        if (Native && block->native) {
+            // Self-loops may go round several times, as far as the limit allows
+            uint64_t allowed = max_instructions ? (max_instructions - count) / block->length : UINT64_MAX;
+            uint64_t left = allowed;
+            pc = block->native(registers, &data_memory, &left);
+            count += (allowed - left) * block->length;
+        } else {
+            for (const ThreadedOp& op : block->ops) op.exec(op, registers, data_memory);
+            pc = finish_block(*block, registers);
+            count += block->length;
+            if (Native && ++block->runs == JitCache::HOT_RUNS) block->native = jit.compile(*block);
+        }
+        if (block->branch == BranchKind::Jalr) {
+            // The target comes from a register: no chaining
+            block = block_cache.lookup(program, INSTRUCTION_MEMORY_START, pc);
+            continue;
+        }
+        // When both successors are the same pc, either chain leads to the same block
+        bool taken = block->branch != BranchKind::None && pc == block->taken_pc;
+        TranslatedBlock*& successor = taken ? block->taken_block : block->next_block;
+        if (!successor) successor = block_cache.lookup(program, INSTRUCTION_MEMORY_START, pc);
+        block = successor;
+    }
+    counters.instret += count;
+    return count;
+}
+
+bool RISCV_Simulator::set_instruction(uint32_t addr, uint32_t word) {
+    uint32_t idx = (addr - INSTRUCTION_MEMORY_START) >> 2;
+    if ((addr & 0x3) || idx >= program.size()) return false;
+    program[idx] = decode_instruction(word);
+    block_cache.invalidate();
+    jit.clear();
+    if (history_enabled()) reset_history();
+    return true;
+}
+
+// =====================================================================
+// REVERSE EXECUTION
+// =====================================================================
+void RISCV_Simulator::enable_history(size_t journal_cycles, uint64_t interval, size_t snapshots) {
+    journal.reset(journal_cycles ? journal_cycles : 1);
+    snapshot_interval = interval ? interval : 1;
+    max_snapshots = snapshots ? snapshots : 1;
+    reset_history();
+}
+
+void RISCV_Simulator::disable_history() {
+    snapshot_interval = 0;
+    journal.reset(0);
+    history_snapshots.clear();
+}
+
+void RISCV_Simulator::reset_history() {
+    journal.clear();
+    history_snapshots.clear();
+    history_snapshots.push_back(snapshot());  // So the start of the new history stays reachable
+}
+
+uint64_t RISCV_Simulator::get_history_start() const {
+    uint64_t start = cycle - journal.size();
+    if (!history_snapshots.empty() && history_snapshots.front().cycle < start) {
+        start = history_snapshots.front().cycle;
+    }
+    return start;
+}
+
+void RISCV_Simulator::step_recorded() {
+    CycleDelta& d = journal.push();
+    d.cycle = cycle;
+    d.pc = pc;
+    d.if_id = if_id;
+    d.id_ex = id_ex;
+    d.ex_mem = ex_mem;
+    d.mem_wb = mem_wb;
+    d.fetch_pc = fetch_pc;
+    d.fetch_wait = fetch_wait;
+    d.mem_wait = mem_wait;
+    d.ex_wait = ex_wait;
+    d.fetch_pending = fetch_pending;
+    d.mem_pending = mem_pending;
+    d.ex_pending = ex_pending;
+    d.reg = -1;
+    d.mem_written = false;
+    d.scoreboard_reg = -1;
+    d.branch_resolved = false;
+    d.icache.events = 0;
+    d.dcache.events = 0;
+
+    uint64_t before[PERF_COUNTER_FIELDS];
+    std::memcpy(before, &counters, sizeof(before));
+
+    recording = &d;
+    if (trace_level == TraceLevel::Off) step_impl<false>();
+    else step_impl<true>();
+    recording = nullptr;
+
+    uint64_t after[PERF_COUNTER_FIELDS];
+    std::memcpy(after, &counters, sizeof(after));
+    for (size_t i = 0; i < PERF_COUNTER_FIELDS; i++) d.counters[i] = (uint8_t)(after[i] - before[i]);
+
+    if (cycle % snapshot_interval == 0) {
+        // After a backward seek the snapshots ahead of us are replaced as we pass them
+        while (!history_snapshots.empty() && history_snapshots.back().cycle >= cycle) history_snapshots.pop_back();
+        history_snapshots.push_back(snapshot());
+        if (history_snapshots.size() > max_snapshots) history_snapshots.pop_front();
+    }
+}
+
+void RISCV_Simulator::undo_cycle() {
+    const CycleDelta& d = journal.back();
+
+    if (d.mem_written) data_memory.write32(d.mem_addr, d.mem_old);
+    if (d.reg >= 0) registers[d.reg] = d.reg_old;
+    if (d.scoreboard_reg >= 0) scoreboard[(uint8_t)d.scoreboard_reg] = d.scoreboard_old;
+    if (d.branch_resolved) predictor.revert(d.predictor);
+    icache.revert(d.icache);
+    dcache.revert(d.dcache);
+
+    uint64_t values[PERF_COUNTER_FIELDS];
+    std::memcpy(values, &counters, sizeof(values));
+    for (size_t i = 0; i < PERF_COUNTER_FIELDS; i++) values[i] -= d.counters[i];
+    std::memcpy(&counters, values, sizeof(values));
+
+    cycle = d.cycle;
+    pc = d.pc;
+    stall_pipeline = false;  // Always clear between cycles: IF consumes it
+    fetch_pc = d.fetch_pc;
+    fetch_wait = d.fetch_wait;
+    mem_wait = d.mem_wait;
+    ex_wait = d.ex_wait;
+    fetch_pending = d.fetch_pending;
+    mem_pending = d.mem_pending;
+    ex_pending = d.ex_pending;
+    if_id = if_id_next = d.if_id;
+    id_ex = id_ex_next = d.id_ex;
+    ex_mem = ex_mem_next = d.ex_mem;
+    mem_wb = mem_wb_next = d.mem_wb;
+
+    journal.pop_back();
+}
+
+bool RISCV_Simulator::step_back(uint64_t n) {
+    if (n > cycle) return false;
+    return seek_to_cycle(cycle - n);
+}
+
+bool RISCV_Simulator::seek_to_cycle(uint64_t target) {
+    if (target >= cycle) {
+        while (cycle < target) step();
+        return true;
+    }
+    if (!history_enabled()) return false;
+
+    // Nearest snapshot at or before the target
+    const Snapshot* base = nullptr;
+    for (auto it = history_snapshots.rbegin(); it != history_snapshots.rend(); ++it) {
+        if (it->cycle <= target) {
+            base = &*it;
+            break;
+        }
+    }
+
+    // Undo record by record when the journal reaches and that is no longer than replaying
+    uint64_t distance = cycle - target;
+    if (journal.size() >= distance && (!base || distance <= target - base->cycle)) {
+        while (cycle > target) undo_cycle();
+        return true;
+    }
+    if (!base) return false;
+
+    // Keep only the undo records older than the snapshot, then replay up to the target
+    while (journal.size() > 0 && journal.back().cycle >= base->cycle) journal.pop_back();
+    restore_state(*base);
+    while (cycle < target) step();
+    return true;
+}
@@ -0,0 +1,51 @@
+#include "../hpp_files/step_batch.hpp"
+
+size_t step_batch(RISCV_Simulator& sim, size_t max_cycles, std::vector<uint32_t>& out) {
+    out.clear();
+    out.push_back(0);
+
+    int32_t registers[32];
+    for (int i = 0; i < 32; i++) registers[i] = sim.get_reg(i);
+
+    size_t cycles = 0;
+    while (cycles < max_cycles && !sim.is_halted()) {
+        // A store bumps the counter in the (non-frozen) cycle that performs it
+        uint64_t stores = sim.get_counters().stores;
+        sim.step();
+        cycles++;
+
+        const uint32_t head[2] = { (uint32_t)sim.get_cycle(), sim.get_pc() };
+        LatchWords latches;
+        sim.get_latch_words(latches);
+        out.insert(out.end(), head, head + 2);
+        const uint32_t* words = reinterpret_cast<const uint32_t*>(&latches);
+        out.insert(out.end(), words, words + LATCH_WORDS);
+        size_t info = out.size();
+        out.push_back(0);
+
+        // WB writes at most one register per cycle; comparing all 32 keeps this independent of it
+        uint32_t changed_regs = 0;
+        for (int i = 1; i < 32; i++) {
+            int32_t value = sim.get_reg(i);
+            if (value == registers[i]) continue;
+            registers[i] = value;
+            out.push_back(i);
+            out.push_back((uint32_t)value);
+            changed_regs++;
+        }
+
+        // The store that just left MEM is now in MEM/WB, with its address in ALUOutput
+        uint32_t changed_words = 0;
+        if (sim.get_counters().stores != stores) {
+            uint32_t addr = latches.mem_wb_aluoutput & ~3u;  // SB/SH: the word the store landed in
+            out.push_back(addr);
+            out.push_back(sim.get_mem_word(addr));
+            changed_words++;
+        }
+
+        out[info] = (sim.is_halted() ? 1u : 0u) | (changed_regs << 8) | (changed_words << 16);
+    }
+
+    out[0] = (uint32_t)cycles;
+    return cycles;
+}
@@ -0,0 +1,54 @@
+#include "../hpp_files/trace.hpp"
+#include <iostream>
+#include <cstdio>
+
+static void writeHex(std::ostream& os, uint32_t value) {
+    char buf[11];
+    std::snprintf(buf, sizeof(buf), "0x%08x", value);
+    os.write(buf, 10);
+}
+
+void StreamTraceSink::end_cycle(TraceLevel level, const CycleTrace& trace) {
+    if (level == TraceLevel::Summary) {
+        out << "C" << trace.cycle << " PC=";
+        writeHex(out, trace.pc);
+        out << " IF/ID=";  writeHex(out, trace.if_id_ir);
+        out << " ID/EX=";  writeHex(out, trace.id_ex_ir);
+        out << " EX/MEM="; writeHex(out, trace.ex_mem_ir);
+        out << " MEM/WB="; writeHex(out, trace.mem_wb_ir);
+        if (trace.data_stall) out << " STALL";
+        if (trace.ex_busy) out << " EXBUSY";
+        if (trace.flush) out << " FLUSH";
+        if (trace.icache_wait) out << " IWAIT";
+        if (trace.dcache_wait) out << " DWAIT";
+        out << "\n";
+    } else if (level == TraceLevel::Structured) {
+        out << "{\"cycle\":" << trace.cycle
+            << ",\"pc\":" << trace.pc
+            << ",\"if_id\":" << trace.if_id_ir
+            << ",\"id_ex\":" << trace.id_ex_ir
+            << ",\"ex_mem\":" << trace.ex_mem_ir
+            << ",\"mem_wb\":" << trace.mem_wb_ir
+            << ",\"stall\":" << (trace.data_stall ? "true" : "false")
+            << ",\"ex_busy\":" << (trace.ex_busy ? "true" : "false")
+            << ",\"flush\":" << (trace.flush ? "true" : "false")
+            << ",\"icache_wait\":" << (trace.icache_wait ? "true" : "false")
+            << ",\"dcache_wait\":" << (trace.dcache_wait ? "true" : "false")
+            << "}\n";
+    }
+    // TraceLevel::Full already wrote its narration through text()
+}
+
+TraceSink& consoleTraceSink() {
+    static StreamTraceSink sink(std::cout);
+    return sink;
+}
+
+bool parseTraceLevel(const std::string& name, TraceLevel& level) {
+    if (name == "off")             level = TraceLevel::Off;
+    else if (name == "summary")    level = TraceLevel::Summary;
+    else if (name == "full")       level = TraceLevel::Full;
+    else if (name == "structured") level = TraceLevel::Structured;
+    else return false;
+    return true;
+}
@@ -1,34 +1,46 @@
 #include "../hpp_files/utils.hpp"
+#include <charconv>
 
-unsigned int binToUint(const string& bin) {
-    return stoul(bin, nullptr, 2);
-}
-
-int getRegisterNumber(const string& reg) {
+int getRegisterNumber(string_view reg) {
     if (reg.length() > 1 && reg[0] == 'x') {
-        try {
-            int num = stoi(reg.substr(1));
-            return (num >= 0 && num <= 31) ? num : -1;
-        } catch (...) { return -1; }
+        int num = -1;
+        const char* last = reg.data() + reg.size();
+        auto result = from_chars(reg.data() + 1, last, num);
+        if (result.ec != errc() || result.ptr != last) return -1;  // "x5abc" is not x5
+        return (num >= 0 && num <= 31) ? num : -1;
+    }
+
+    static const string_view abiNames[32] = {
+        "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+        "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+        "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+        "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+    };
+    for (int num = 0; num < 32; num++) {
+        if (reg == abiNames[num]) return num;
     }
+    if (reg == "fp") return 8;  // s0
     return -1;
 }
 
-int getImmediateValue(const string& immStr) {
-    try {
-        if (immStr.size() > 2 && immStr.substr(0, 2) == "0x")
-            return stoul(immStr, nullptr, 16);
-        else return stoi(immStr);
-    } catch (...) { return 999999999; }
+// Decimal (optionally negative) or 0x hex; hex values are taken modulo 2^32.
+// The whole token must be a number: "12abc" is an error, not 12.
+bool parseImmediate(string_view immStr, int& value) {
+    const char* first = immStr.data();
+    const char* last = immStr.data() + immStr.size();
+    if (immStr.size() > 2 && immStr.substr(0, 2) == "0x") {
+        unsigned long long wide = 0;
+        auto result = from_chars(first + 2, last, wide, 16);
+        if (result.ec != errc() || result.ptr != last) return false;
+        value = (int)(uint32_t)wide;
+        return true;
+    }
+    if (first != last && *first == '+') first++;
+    auto result = from_chars(first, last, value);
+    return result.ec == errc() && result.ptr == last;
 }
 
-vector<string> split(const string& s, char delimiter) {
-    vector<string> tokens;
-    string token;
-    istringstream tokenStream(s);
-    while (getline(tokenStream, token, delimiter)) {
-        token.erase(remove_if(token.begin(), token.end(), ::isspace), token.end());
-        if (!token.empty()) tokens.push_back(token);
-    }
-    return tokens;
+int getImmediateValue(string_view immStr) {
+    int value = 0;
+    return parseImmediate(immStr, value) ? value : 999999999;
 }
@@ -0,0 +1,26 @@
+# Nested loops for comparing branch predictors (--predictor=not-taken|btfn|bht|btb)
+.data
+    limit: .word 1073741824  # Address 0x00 (2^30)
+    one:   .word 1           # Address 0x04
+.text
+.global main
+
+main:
+    lw x1, 0(x0)        # x1 = 2^30 (loop bound)
+    lw x5, 4(x0)        # x5 = 1 (outer counter)
+
+OUTER:
+    lw x2, 4(x0)        # x2 = 1 (inner counter)
+
+INNER:
+    slli x2, x2, 1      # x2 <<= 1
+    slt x3, x2, x1      # x3 = (x2 < bound)
+    sw x2, 8(x0)        # Keep the latest inner value at 0x08
+    blt x2, x1, INNER   # Backward branch, taken 29 of 30 times
+
+    slli x5, x5, 1      # x5 <<= 1
+    blt x5, x1, OUTER   # Backward branch, taken 29 of 30 times
+
+    sw x5, 12(x0)       # Store 2^30 at 0x0C
+
+    # expect: x1=0x40000000 x2=0x40000000 x3=0 x5=0x40000000 mem[8]=0x40000000 mem[12]=0x40000000 instret=3693 cycles=8375
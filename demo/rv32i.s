@@ -0,0 +1,59 @@
+# RV32I tour: upper immediates, byte/halfword memory, shifts, compares and a call, in a loop
+.data
+    bytes: .word 0x80FF7F01  # Address 0x00: bytes 01 7F FF 80
+.text
+.global main
+
+main:
+    addi  s9, zero, 20       # Iterations: more than the JIT interprets a block (HOT_RUNS = 16)
+    addi  s11, zero, 0       # i
+    addi  s10, zero, 0       # Checksum of the sign-extended bytes
+loop:
+    lui   t0, 0x12345        # t0 = 0x12345000
+    addi  t0, t0, 0x678      # t0 = 0x12345678
+    add   t0, t0, s11        # t0 = 0x12345678 + i
+    auipc t1, 0              # t1 = pc = 0x98
+    sb    t0, 8(zero)        # mem[8] = 0x78 + i (one byte)
+    sh    t0, 12(zero)       # mem[12] = 0x5678 + i (two bytes)
+    lb    a0, 8(zero)        # Sign-extended: negative from i = 8 on
+    lbu   a2, 8(zero)        # 0x78 + i
+    lh    a3, 12(zero)       # 0x5678 + i
+    lh    a1, 2(zero)        # 0xFFFF80FF
+    lhu   a4, 2(zero)        # 0x80FF
+    addi  s0, zero, -5
+    srai  s1, s0, 1          # -3
+    srli  s2, s0, 28         # 15
+    sltiu s3, s0, 3          # 0 (0xFFFFFFFB is not below 3 unsigned)
+    slti  s4, s0, 3          # 1
+    xori  s5, s0, -1         # 4 (not)
+    ori   s6, zero, 0x0F0
+    andi  s7, t0, 0xFF       # 0x78 + i
+    sub   t2, zero, s0       # 5
+    xor   t3, t0, t0         # 0
+    sra   t4, s0, s2         # -1
+    srl   t5, s0, s2         # 0x1FFFF
+    or    t6, s6, s2         # 0xFF
+    and   a5, t6, s7         # 0x78 + i
+    sltu  a6, zero, s0       # 1
+    slt   s8, s0, zero       # 1
+    jal   ra, func           # ra = 0xFC, a7 = 7
+    addi  a7, a7, 100        # 107
+    bne   a7, zero, skip
+    addi  a7, zero, -1       # Skipped
+skip:
+    bge   s0, zero, bad      # -5 >= 0: not taken
+    bltu  s0, zero, bad      # Nothing is below 0 unsigned: not taken
+    bgeu  s0, zero, next     # Taken
+bad:
+    addi  gp, gp, 1          # Never reached
+next:
+    add   s10, s10, a0
+    addi  s11, s11, 1
+    blt   s11, s9, loop
+    beq   zero, zero, end
+func:
+    addi  a7, zero, 7
+    jalr  zero, 0(ra)        # Return
+end:
+    add   tp, a7, zero       # 107
+    # expect: t0=0x1234568B t1=0x98 a0=-117 a1=0xFFFF80FF a2=0x8B a3=0x568B a4=0x80FF s1=-3 s2=15 s3=0 s4=1 s5=4 s7=0x8B a5=0x8B t2=5 t3=0 t4=-1 t5=0x1FFFF a6=1 s8=1 ra=0xFC gp=0 tp=107 s10=-482 s11=20 mem[8]=0x8B mem[12]=0x568B instret=765 cycles=1369
@@ -0,0 +1,35 @@
+# RV32M: high-multiply signedness, division corner cases and multiply/divide latency
+.data
+    neg3:   .word -3          # Address 0x00
+    minint: .word 0x80000000  # Address 0x04 (INT32_MIN)
+.text
+.global main
+
+main:
+    lw     x1, 0(x0)          # x1 = -3
+    lw     x2, 4(x0)          # x2 = INT32_MIN
+    addi   x3, x0, 7          # x3 = 7
+    addi   x4, x0, -1         # x4 = -1
+    mulh   x5, x1, x3         # -3 * 7 = -21: high word -1
+    mulhsu x6, x1, x3         # Signed -3 * unsigned 7: high word -1
+    mulhu  x7, x1, x3         # 0xFFFFFFFD * 7 = 0x6_FFFFFFEB: high word 6
+    mulh   x8, x1, x1         # -3 * -3 = 9: high word 0
+    mulhu  x9, x1, x1         # 0xFFFFFFFD^2 = 0xFFFFFFFA_00000009
+    mulhsu x10, x3, x1        # 7 * unsigned 0xFFFFFFFD: high word 6
+    mulhsu x25, x1, x1        # -3 * unsigned 0xFFFFFFFD: high word -3
+    div    x11, x3, x0        # Divide by zero: -1
+    divu   x12, x3, x0        # Divide by zero: 0xFFFFFFFF
+    rem    x13, x3, x0        # Remainder by zero: the dividend, 7
+    remu   x14, x1, x0        # Remainder by zero: the dividend, -3
+    div    x15, x2, x4        # INT32_MIN / -1 overflows to INT32_MIN
+    rem    x16, x2, x4        # ... with remainder 0
+    mul    x17, x3, x3        # 49
+    mul    x18, x17, x3       # Needs the previous product: 343
+    mul    x19, x3, x1        # Back-to-back independent multiplies: -21
+    mul    x20, x1, x1        # 9
+    div    x21, x18, x3       # 343 / 7 = 49
+    add    x22, x21, x19      # Waits for the divide: 49 + -21 = 28
+    rem    x23, x1, x3        # -3 rem 7 = -3 (sign of the dividend)
+    divu   x24, x1, x3        # 0xFFFFFFFD / 7 = 613566756
+    sw     x22, 8(x0)         # mem[8] = 28
+    # expect: x5=-1 x6=-1 x7=6 x8=0 x9=0xFFFFFFFA x10=6 x25=-3 x11=-1 x12=0xFFFFFFFF x13=7 x14=-3 x15=0x80000000 x16=0 x17=49 x18=343 x19=-21 x20=9 x21=49 x22=28 x23=-3 x24=613566756 mem[8]=28 instret=26 cycles=318
@@ -56,4 +56,6 @@ CALC:
     sll x8, x6, x7      # x8 = 160 << 1 = 320
     
     # 8. Store Final Result
-    sw x8, 16(x0)       # Store 320 at address 0x10
\ No newline at end of file
+    sw x8, 16(x0)       # Store 320 at address 0x10
+
+    # expect: x3=40 x4=25 x5=40 x6=160 x7=1 x8=320 mem[12]=40 mem[16]=320 instret=13 cycles=36
@@ -0,0 +1,86 @@
+#ifndef ALU_HPP
+#define ALU_HPP
+
+#include "memory.hpp"
+#include <cstdint>
+
+// Instruction semantics shared by the EX/MEM stages and the functional handlers,
+// so the pipeline and the functional paths cannot drift apart.
+
+// OP and OP-IMM results. `alt` selects SUB and SRA/SRAI (funct7 0x20); shift
+// amounts use the low five bits of b.
+// funct3: 0 ADD/SUB, 1 SLL, 2 SLT, 3 SLTU, 4 XOR, 5 SRL/SRA, 6 OR, 7 AND
+inline int32_t alu_result(uint8_t funct3, bool alt, int32_t a, int32_t b) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (funct3 & 0x7) {
+    case 0: return (int32_t)(alt ? ua - ub : ua + ub);
+    case 1: return (int32_t)(ua << (ub & 0x1F));
+    case 2: return a < b ? 1 : 0;
+    case 3: return ua < ub ? 1 : 0;
+    case 4: return (int32_t)(ua ^ ub);
+    case 5: return alt ? a >> (ub & 0x1F) : (int32_t)(ua >> (ub & 0x1F));
+    case 6: return (int32_t)(ua | ub);
+    default: return (int32_t)(ua & ub);
+    }
+}
+
+// Conditional branches; the two reserved encodings are never taken.
+// funct3: 0 BEQ, 1 BNE, 4 BLT, 5 BGE, 6 BLTU, 7 BGEU
+inline bool branch_condition(uint8_t funct3, int32_t a, int32_t b) {
+    switch (funct3 & 0x7) {
+    case 0: return a == b;
+    case 1: return a != b;
+    case 4: return a < b;
+    case 5: return a >= b;
+    case 6: return (uint32_t)a < (uint32_t)b;
+    case 7: return (uint32_t)a >= (uint32_t)b;
+    default: return false;
+    }
+}
+
+// Loads, sign- or zero-extended to 32 bits; reserved widths read a word.
+// funct3: 0 LB, 1 LH, 2 LW, 4 LBU, 5 LHU
+inline int32_t load_value(uint8_t funct3, const SparseMemory& mem, uint32_t addr) {
+    switch (funct3 & 0x7) {
+    case 0: return (int8_t)mem.read8(addr);
+    case 1: return (int16_t)mem.read16(addr);
+    case 4: return mem.read8(addr);
+    case 5: return mem.read16(addr);
+    default: return (int32_t)mem.read32(addr);
+    }
+}
+
+// Stores the low byte, half or the whole of value; reserved widths store a word.
+// funct3: 0 SB, 1 SH, 2 SW
+inline void store_value(uint8_t funct3, SparseMemory& mem, uint32_t addr, uint32_t value) {
+    switch (funct3 & 0x7) {
+    case 0: mem.write8(addr, (uint8_t)value); break;
+    case 1: mem.write16(addr, (uint16_t)value); break;
+    default: mem.write32(addr, value); break;
+    }
+}
+
+// RV32M results, following the spec's corner cases: division by zero gives all ones (DIV/DIVU) or
+// the dividend (REM/REMU), and INT32_MIN / -1 overflows to INT32_MIN rem 0.
+// funct3: 0 MUL, 1 MULH, 2 MULHSU, 3 MULHU, 4 DIV, 5 DIVU, 6 REM, 7 REMU
+inline int32_t muldiv_result(uint8_t funct3, int32_t a, int32_t b) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (funct3 & 0x7) {
+    case 0: return (int32_t)(ua * ub);
+    case 1: return (int32_t)(((int64_t)a * (int64_t)b) >> 32);
+    case 2: return (int32_t)((uint64_t)((int64_t)a * (int64_t)ub) >> 32);
+    case 3: return (int32_t)(((uint64_t)ua * (uint64_t)ub) >> 32);
+    case 4:
+        if (b == 0) return -1;
+        if (a == INT32_MIN && b == -1) return INT32_MIN;
+        return a / b;
+    case 5: return b == 0 ? -1 : (int32_t)(ua / ub);
+    case 6:
+        if (b == 0) return a;
+        if (a == INT32_MIN && b == -1) return 0;
+        return a % b;
+    default: return b == 0 ? a : (int32_t)(ua % ub);
+    }
+}
+
+#endif
@@ -10,29 +10,37 @@
 #include <iomanip>
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
 
 using namespace std;
 
 const unsigned int INSTRUCTION_MEMORY_START = 0x80;
 const unsigned int DATA_MEMORY_START = 0x00; // Data starts at 0
 
-struct InstructionInfo {
-    string type, op, f3, f7;
-    InstructionInfo(string t, string o, string f) : type(t), op(o), f3(f), f7("") {}
-    InstructionInfo(string t, string o, string f3_val, string f7_val)
-        : type(t), op(o), f3(f3_val), f7(f7_val) {}
-};
+struct InstructionDef;
 
+// The string_views point into the Program's source buffer
 struct ParsedInstruction {
-    string mnemonic;
-    vector<string> operands;
+    const InstructionDef* def;      // Entry in INSTRUCTION_SET (instruction_set.hpp)
+    string_view mnemonic;
+    string_view operands[3];        // Register, register/label, immediate/label; lw/sw: reg, base, offset
+    uint8_t operand_count;
     unsigned int address;
-    string originalLine;
+    unsigned int line;              // 1-based line number in the source
+    string_view originalLine;       // The source line without its comment and surrounding whitespace
 };
 
-extern map<string, InstructionInfo> INSTRUCTION_SET;
-extern map<unsigned int, unsigned int> INSTRUCTION_MEMORY;
-extern map<string, unsigned int> SYMBOL_TABLE;
-extern map<unsigned int, int32_t> DATA_SEGMENT; 
+// Everything the assembler produces for one source: the inputs a simulator is
+// built from plus what a front end needs to list it. Copies share the source text.
+struct Program {
+    shared_ptr<const void> source_owner;                // Keeps `source` alive: a string or a file mapping
+    string_view source;
+    unordered_map<string_view, unsigned int> symbols;   // Label -> address
+    map<unsigned int, int32_t> data;                    // .data image, address -> .word value
+    vector<ParsedInstruction> instructions;
+    vector<uint32_t> machine_code;                      // Encoded words from INSTRUCTION_MEMORY_START
+};
 
 #endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include "alu.hpp"
+#include "decoder.hpp"
+#include "memory.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Threaded code for the functional path: each straight-line run of instructions,
+// up to and including the branch or jump that ends it, is translated once into handler
+// pointers with their operands already extracted. Blocks that end in a branch or
+// JAL are cached by start PC and link to their successors the first time control
+// passes to them; the target of a JALR is looked up every time.
+
+// What a ThreadedOp does, for code generators that do not go through the handler
+enum class OpKind : uint8_t {
+    None,
+    Add, Sub, Sll, Slt, Sltu, Xor, Srl, Sra, Or, And,
+    Addi, Slti, Sltiu, Xori, Ori, Andi, Slli, Srli, Srai,
+    Lb, Lh, Lw, Lbu, Lhu, Sb, Sh, Sw,
+    Li,                                              // rd = imm (LUI, and AUIPC with the pc folded in)
+    Mul, Mulh, Mulhsu, Mulhu, Div, Divu, Rem, Remu   // RV32M, in funct3 order
+};
+
+// One instruction that does not end a block, bound to its handler
+struct ThreadedOp {
+    using Handler = void (*)(const ThreadedOp& op, int32_t* regs, SparseMemory& mem);
+
+    Handler exec;     // nullptr for instructions with no effect (writes to x0)
+    OpKind kind;
+    uint8_t rd, rs1, rs2;
+    int32_t imm;
+};
+
+// Host code for a whole block (jit.hpp): runs it and returns the next pc. A block
+// that branches back to its own start keeps looping in host code for up to
+// *iterations runs; every block leaves *iterations reduced by the runs it made.
+using NativeBlock = uint32_t (*)(int32_t* regs, SparseMemory* mem, uint64_t* iterations);
+
+enum class BranchKind : uint8_t {
+    None,   // Block ends at the end of the program (or an empty slot): always falls through
+    Never,  // A reserved branch encoding: never taken
+    Eq, Ne, Lt, Ge, Ltu, Geu,   // Conditional branches
+    Jal,    // Always taken, to taken_pc
+    Jalr    // Always taken, to (rs1 + imm) & ~1
+};
+
+struct TranslatedBlock {
+    uint32_t start_pc;
+    uint32_t length;                    // Instructions, the branch or jump included
+    std::vector<ThreadedOp> ops;        // Everything before the branch or jump that has an effect
+
+    BranchKind branch;
+    uint8_t rs1, rs2;
+    uint8_t rd;                         // Jumps: link register
+    int32_t imm;                        // JALR: offset from rs1
+    uint32_t taken_pc;                  // Unused for JALR
+    uint32_t next_pc;                   // Fall-through, and a jump's link value
+    TranslatedBlock* taken_block;       // Chained successors, nullptr until first followed
+    TranslatedBlock* next_block;
+
+    uint32_t runs;                      // Times run_jit() has interpreted the block
+    NativeBlock native;                 // Compiled once hot, nullptr until then
+};
+
+// The same semantics step_functional() has always had, one instruction at a time.
+// pc is the instruction's own address (AUIPC folds it into a constant).
+ThreadedOp translate_op(const ID_EX& c, uint32_t pc);
+BranchKind branch_kind(const ID_EX& c);
+
+// Conditional branches go through branch_condition (alu.hpp), as the pipeline's do
+inline bool branch_taken(BranchKind kind, int32_t a, int32_t b) {
+    static const uint8_t funct3[] = {0, 1, 4, 5, 6, 7};  // Eq .. Geu
+    switch (kind) {
+    case BranchKind::Jal:
+    case BranchKind::Jalr:  return true;
+    case BranchKind::None:
+    case BranchKind::Never: return false;
+    default:                return branch_condition(funct3[(int)kind - (int)BranchKind::Eq], a, b);
+    }
+}
+
+// Runs the branch or jump that ends the block (writing a jump's link) and returns the next pc
+inline uint32_t finish_block(const TranslatedBlock& block, int32_t* regs) {
+    if (block.branch == BranchKind::Jalr) {
+        uint32_t target = ((uint32_t)regs[block.rs1] + (uint32_t)block.imm) & ~1u;  // Read before the link is written
+        if (block.rd != 0) regs[block.rd] = (int32_t)block.next_pc;
+        return target;
+    }
+    if (block.branch == BranchKind::Jal) {
+        if (block.rd != 0) regs[block.rd] = (int32_t)block.next_pc;
+        return block.taken_pc;
+    }
+    return branch_taken(block.branch, regs[block.rs1], regs[block.rs2]) ? block.taken_pc : block.next_pc;
+}
+
+class BlockCache {
+public:
+    BlockCache() = default;
+    // Blocks are derived from the program, so a copy starts out empty
+    BlockCache(const BlockCache&) {}
+    BlockCache& operator=(const BlockCache&) { invalidate(); return *this; }
+
+    // The block starting at pc, translated from `program` (slot (pc - base) >> 2)
+    // on first use; nullptr if there is no instruction at pc
+    TranslatedBlock* lookup(const std::vector<DecodedInst>& program, uint32_t base, uint32_t pc);
+
+    // Drops every block, and with them every chain into them. Call whenever the
+    // instructions the blocks were translated from change.
+    void invalidate() { blocks.clear(); }
+
+    size_t size() const;  // Blocks translated so far
+
+private:
+    std::vector<std::unique_ptr<TranslatedBlock>> blocks;  // By slot of the start pc
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef BRANCH_PREDICTOR_HPP
+#define BRANCH_PREDICTOR_HPP
+
+#include "decoder.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class PredictorKind : uint8_t {
+    NotTaken,  // Always fall through (the original pipeline)
+    BTFN,      // Backward taken, forward not taken
+    BHT,       // 2-bit saturating counters indexed by PC
+    BTB        // Direct-mapped branch target buffer with 2-bit counters
+};
+
+struct BranchPrediction {
+    bool     taken;
+    uint32_t target;  // Only meaningful when taken
+};
+
+struct PredictorStats {
+    uint64_t branches;     // Branches and jumps resolved in EX
+    uint64_t taken;        // ... of which were taken
+    uint64_t mispredicts;  // Wrong direction or wrong target
+
+    double accuracy() const { return branches ? (double)(branches - mispredicts) / branches : 1.0; }
+};
+
+// Fetch-stage predictor. IF asks predict() for every fetched instruction;
+// EX reports each resolved branch and jump through update().
+class BranchPredictor {
+private:
+    struct BTBEntry {
+        uint32_t tag;      // Full PC of the branch
+        uint32_t target;
+        uint8_t  counter;  // 2-bit saturating, >= 2 predicts taken
+        bool     valid;
+    };
+
+    PredictorKind kind;
+    std::vector<uint8_t>  bht;   // 2-bit counters, start weakly not-taken
+    std::vector<BTBEntry> btb;
+    PredictorStats stats;
+
+    static uint32_t index(uint32_t pc, size_t entries) { return (pc >> 2) % entries; }
+
+public:
+    BranchPredictor(PredictorKind k = PredictorKind::NotTaken, unsigned bht_entries = 64, unsigned btb_entries = 16);
+
+    // `inst` is the predecoded instruction at pc; static schemes and the BHT use
+    // its immediate for the target (decode-at-fetch), the BTB uses its own entries.
+    BranchPrediction predict(uint32_t pc, const DecodedInst& inst) const;
+
+    // What one update() changed, so reverse execution can take it back
+    struct Undo {
+        uint32_t pc;
+        bool     taken;
+        bool     mispredicted;
+        uint8_t  bht_counter;
+        BTBEntry btb_entry;
+    };
+
+    // Trains the predictor with a resolved branch and records whether it was mispredicted.
+    // With `undo`, also saves what it overwrote for revert().
+    void update(uint32_t pc, bool taken, uint32_t target, bool mispredicted, Undo* undo = nullptr);
+    void revert(const Undo& undo);
+
+    PredictorKind get_kind() const { return kind; }
+    const PredictorStats& get_stats() const { return stats; }
+};
+
+// "not-taken" / "btfn" / "bht" / "btb"
+bool parsePredictorKind(const std::string& name, PredictorKind& kind);
+const char* predictorKindName(PredictorKind kind);
+
+#endif
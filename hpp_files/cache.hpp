@@ -0,0 +1,89 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ReplacementPolicy : uint8_t {
+    LRU,     // Evict the least recently used way
+    FIFO,    // Evict the way filled longest ago
+    Random   // Evict a pseudo-random way (fixed seed, so runs are reproducible)
+};
+
+// Geometry and timing of one L1 cache. Sizes are in bytes and must be powers of two.
+struct CacheConfig {
+    bool enabled = false;        // Disabled: every access takes one cycle (the original pipeline)
+    unsigned size = 4096;
+    unsigned ways = 2;
+    unsigned line_size = 32;
+    ReplacementPolicy policy = ReplacementPolicy::LRU;
+    bool write_back = true;      // false = write-through, no write-allocate
+    unsigned hit_latency = 1;    // Cycles for a hit; 1 adds no stall
+    unsigned miss_latency = 10;  // Extra cycles to fill a line (or write a word/line to memory)
+};
+
+struct CacheStats {
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;   // Valid lines replaced by a fill
+    uint64_t writebacks;  // Dirty lines written to memory on eviction (write-back only)
+
+    uint64_t accesses() const { return reads + writes; }
+    double hit_rate() const { return accesses() ? (double)hits / accesses() : 0.0; }
+};
+
+// Tag-only timing model: data always lives in SparseMemory, the cache decides
+// how many cycles an access takes. Accesses are assumed not to straddle a line.
+class Cache {
+private:
+    struct Line {
+        uint32_t tag;
+        uint64_t stamp;  // Last use (LRU) or fill time (FIFO)
+        bool     valid;
+        bool     dirty;
+    };
+
+    CacheConfig config;
+    unsigned sets;
+    unsigned offset_bits;
+    unsigned index_bits;
+    std::vector<Line> lines;  // sets * ways, one set after another
+    uint64_t tick;
+    uint32_t rng;
+    CacheStats stats;
+
+    unsigned choose_victim(Line* set);
+
+public:
+    explicit Cache(const CacheConfig& cfg = CacheConfig());
+
+    // What one access() changed, so reverse execution can take it back
+    struct Undo {
+        enum : uint8_t { ACCESSED = 1, WRITE = 2, HIT = 4, EVICTION = 8, WRITEBACK = 16 };
+        uint8_t  events;  // 0: no access to revert
+        int32_t  line;    // Index into lines of the line it changed, -1 for none
+        Line     old;
+        uint32_t rng;
+    };
+
+    // Looks up addr, updating tags and stats. Returns the cycles the access takes.
+    // With `undo`, also saves what it overwrote for revert().
+    unsigned access(uint32_t addr, bool write, Undo* undo = nullptr);
+    void revert(const Undo& undo);
+
+    bool enabled() const { return config.enabled; }
+    const CacheConfig& get_config() const { return config; }
+    const CacheStats& get_stats() const { return stats; }
+};
+
+// "lru" / "fifo" / "random"
+bool parseReplacementPolicy(const std::string& name, ReplacementPolicy& policy);
+const char* replacementPolicyName(ReplacementPolicy policy);
+
+// Empty string if the geometry is usable, otherwise what is wrong with it
+std::string validateCacheConfig(const CacheConfig& config);
+
+#endif
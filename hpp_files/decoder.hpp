@@ -0,0 +1,37 @@
+#ifndef DECODER_HPP
+#define DECODER_HPP
+
+#include "pipeline_structs.hpp"
+#include <cstdint>
+
+// Opcode Constants
+#define OP_R_TYPE 0x33
+#define OP_I_TYPE 0x13
+#define OP_LOAD   0x03
+#define OP_STORE  0x23
+#define OP_BRANCH 0x63
+#define OP_LUI    0x37
+#define OP_AUIPC  0x17
+#define OP_JAL    0x6F
+#define OP_JALR   0x67
+
+// funct7 of the RV32M instructions (OP_R_TYPE); funct3 bit 2 set means divide/remainder
+#define FUNCT7_MULDIV 0x01
+
+// An instruction decoded once at program load.
+// ctrl holds everything ID would put in ID/EX except the register values (A, B) and NPC.
+struct DecodedInst {
+    ID_EX ctrl;
+    bool  needs_rs1;   // Reads rs1 (for RAW hazard detection)
+    bool  needs_rs2;   // Reads rs2
+};
+
+// 0=I, 1=S, 2=B (byte offset, bit 0 always clear), 3=U (already shifted up 12), 4=J (byte offset)
+int32_t sign_extend_imm(uint32_t inst, int type);
+
+DecodedInst decode_instruction(uint32_t inst);
+
+inline bool is_muldiv(const ID_EX& c) { return c.opcode == OP_R_TYPE && c.func7 == FUNCT7_MULDIV; }
+inline bool is_divide(const ID_EX& c) { return is_muldiv(c) && (c.func3 & 0x4); }
+
+#endif
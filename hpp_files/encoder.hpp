@@ -2,13 +2,23 @@
 #define ENCODER_HPP
 
 #include "assembler.hpp"
+#include "instruction_set.hpp"
 #include "utils.hpp"
 
-unsigned int encodeRType(string rd, string rs1, string rs2, string f3, string f7, string op);
-unsigned int encodeIType(string rd, string rs1, int imm, string f3, string op, const string& mnemonic);
-unsigned int encodeSType(string rs1, string rs2, int imm, string f3, string op);
-unsigned int encodeBType(string rs1, string rs2, int imm, string f3, string op);
-unsigned int encodeJType(string rd, int imm, string op);
-map<unsigned int, unsigned int> translateToOpcode(const vector<ParsedInstruction>& instructions);
+// Field encoders: register numbers and immediates in, one machine word out.
+// Register numbers are masked to 5 bits and immediates to their field width.
+uint32_t encodeRType(unsigned rd, unsigned rs1, unsigned rs2, const InstructionDef& def);
+uint32_t encodeIType(unsigned rd, unsigned rs1, int32_t imm, const InstructionDef& def);  // I, IShift and Load
+uint32_t encodeSType(unsigned rs1, unsigned rs2, int32_t imm, const InstructionDef& def);
+uint32_t encodeBType(unsigned rs1, unsigned rs2, int32_t imm, const InstructionDef& def);
+uint32_t encodeUType(unsigned rd, int32_t imm, const InstructionDef& def);  // imm is the upper 20 bits
+uint32_t encodeJType(unsigned rd, int32_t imm, const InstructionDef& def);
+
+// Encodes one parsed instruction (operand count already checked by the parser).
+// `offset` is the branch/jump target minus inst.address; other formats ignore it.
+uint32_t encodeInstruction(const ParsedInstruction& inst, int32_t offset);
+
+// Fills in the offset of a B- or J-type word that was encoded with offset 0
+uint32_t patchOffset(uint32_t word, int32_t offset);
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+#include "pipeline_structs.hpp"
+#include "perf_counters.hpp"
+#include "branch_predictor.hpp"
+#include "cache.hpp"
+#include "scoreboard.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static const size_t PERF_COUNTER_FIELDS = sizeof(PerfCounters) / sizeof(uint64_t);
+
+// Undo record for one step(): everything the cycle overwrote. At a cycle
+// boundary every *_next latch equals its latch, so one copy of each is enough.
+struct CycleDelta {
+    uint64_t cycle;    // Cycle count before the step
+    uint32_t pc;
+    IF_ID  if_id;
+    ID_EX  id_ex;
+    EX_MEM ex_mem;
+    MEM_WB mem_wb;
+
+    uint32_t fetch_pc;
+    unsigned fetch_wait;
+    unsigned mem_wait;
+    unsigned ex_wait;
+    bool     fetch_pending;
+    bool     mem_pending;
+    bool     ex_pending;
+
+    uint8_t counters[PERF_COUNTER_FIELDS];  // Amount each counter went up (a cycle adds at most a few)
+
+    int8_t   reg;        // Register WB wrote, -1 for none
+    int32_t  reg_old;
+    bool     mem_written;
+    uint32_t mem_addr;   // Word MEM stored to
+    uint32_t mem_old;
+
+    int8_t   scoreboard_reg;   // Register ID issued a write to, -1 for none
+    Scoreboard::Entry scoreboard_old;
+
+    bool branch_resolved;
+    BranchPredictor::Undo predictor;
+    Cache::Undo icache;
+    Cache::Undo dcache;
+};
+
+// Bounded ring of CycleDeltas, oldest first. Pushing onto a full journal drops the oldest.
+class DeltaJournal {
+private:
+    std::vector<CycleDelta> ring;
+    size_t head;   // Index of the oldest entry
+    size_t count;
+
+public:
+    DeltaJournal() : head(0), count(0) {}
+
+    void reset(size_t capacity) {
+        ring.assign(capacity, CycleDelta());
+        head = 0;
+        count = 0;
+    }
+    void clear() { head = 0; count = 0; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return ring.size(); }
+
+    // New newest entry (uninitialized contents)
+    CycleDelta& push() {
+        if (count == ring.size()) {
+            head = (head + 1) % ring.size();
+            count--;
+        }
+        return ring[(head + count++) % ring.size()];
+    }
+    CycleDelta& back() { return ring[(head + count - 1) % ring.size()]; }
+    const CycleDelta& front() const { return ring[head]; }
+    void pop_back() { count--; }
+};
+
+#endif
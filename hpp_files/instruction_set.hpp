@@ -0,0 +1,154 @@
+#ifndef INSTRUCTION_SET_HPP
+#define INSTRUCTION_SET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Operand layout and encoding format of a mnemonic
+enum class InstFormat : uint8_t {
+    R,       // rd, rs1, rs2
+    I,       // rd, rs1, imm
+    IShift,  // rd, rs1, shamt (funct7 in [31:25])
+    Load,    // rd, imm(rs1) (also jalr)
+    S,       // rs2, imm(rs1)
+    B,       // rs1, rs2, label
+    U,       // rd, imm (the upper 20 bits)
+    J,       // rd, label
+};
+
+struct InstructionDef {
+    std::string_view mnemonic;
+    InstFormat format;
+    uint8_t opcode;
+    uint8_t funct3;
+    uint8_t funct7;
+};
+
+// RV32I (without FENCE, ECALL and EBREAK) and RV32M
+inline constexpr InstructionDef INSTRUCTION_SET[] = {
+    {"add",    InstFormat::R,      0x33, 0x0, 0x00},
+    {"sub",    InstFormat::R,      0x33, 0x0, 0x20},
+    {"sll",    InstFormat::R,      0x33, 0x1, 0x00},
+    {"slt",    InstFormat::R,      0x33, 0x2, 0x00},
+    {"sltu",   InstFormat::R,      0x33, 0x3, 0x00},
+    {"xor",    InstFormat::R,      0x33, 0x4, 0x00},
+    {"srl",    InstFormat::R,      0x33, 0x5, 0x00},
+    {"sra",    InstFormat::R,      0x33, 0x5, 0x20},
+    {"or",     InstFormat::R,      0x33, 0x6, 0x00},
+    {"and",    InstFormat::R,      0x33, 0x7, 0x00},
+
+    {"mul",    InstFormat::R,      0x33, 0x0, 0x01},
+    {"mulh",   InstFormat::R,      0x33, 0x1, 0x01},
+    {"mulhsu", InstFormat::R,      0x33, 0x2, 0x01},
+    {"mulhu",  InstFormat::R,      0x33, 0x3, 0x01},
+    {"div",    InstFormat::R,      0x33, 0x4, 0x01},
+    {"divu",   InstFormat::R,      0x33, 0x5, 0x01},
+    {"rem",    InstFormat::R,      0x33, 0x6, 0x01},
+    {"remu",   InstFormat::R,      0x33, 0x7, 0x01},
+
+    {"addi",   InstFormat::I,      0x13, 0x0, 0x00},
+    {"slti",   InstFormat::I,      0x13, 0x2, 0x00},
+    {"sltiu",  InstFormat::I,      0x13, 0x3, 0x00},
+    {"xori",   InstFormat::I,      0x13, 0x4, 0x00},
+    {"ori",    InstFormat::I,      0x13, 0x6, 0x00},
+    {"andi",   InstFormat::I,      0x13, 0x7, 0x00},
+    {"slli",   InstFormat::IShift, 0x13, 0x1, 0x00},
+    {"srli",   InstFormat::IShift, 0x13, 0x5, 0x00},
+    {"srai",   InstFormat::IShift, 0x13, 0x5, 0x20},
+
+    {"lb",     InstFormat::Load,   0x03, 0x0, 0x00},
+    {"lh",     InstFormat::Load,   0x03, 0x1, 0x00},
+    {"lw",     InstFormat::Load,   0x03, 0x2, 0x00},
+    {"lbu",    InstFormat::Load,   0x03, 0x4, 0x00},
+    {"lhu",    InstFormat::Load,   0x03, 0x5, 0x00},
+
+    {"sb",     InstFormat::S,      0x23, 0x0, 0x00},
+    {"sh",     InstFormat::S,      0x23, 0x1, 0x00},
+    {"sw",     InstFormat::S,      0x23, 0x2, 0x00},
+
+    {"beq",    InstFormat::B,      0x63, 0x0, 0x00},
+    {"bne",    InstFormat::B,      0x63, 0x1, 0x00},
+    {"blt",    InstFormat::B,      0x63, 0x4, 0x00},
+    {"bge",    InstFormat::B,      0x63, 0x5, 0x00},
+    {"bltu",   InstFormat::B,      0x63, 0x6, 0x00},
+    {"bgeu",   InstFormat::B,      0x63, 0x7, 0x00},
+
+    {"lui",    InstFormat::U,      0x37, 0x0, 0x00},
+    {"auipc",  InstFormat::U,      0x17, 0x0, 0x00},
+    {"jal",    InstFormat::J,      0x6F, 0x0, 0x00},
+    {"jalr",   InstFormat::Load,   0x67, 0x0, 0x00},
+};
+inline constexpr size_t INSTRUCTION_COUNT = sizeof(INSTRUCTION_SET) / sizeof(INSTRUCTION_SET[0]);
+
+// Mnemonic lookup through a perfect hash built at compile time: a seeded FNV-1a
+// hash with the first seed that puts every mnemonic in its own slot, so a lookup
+// is one hash, one slot and one compare
+namespace instruction_hash {
+
+// Smallest power of two at least four times INSTRUCTION_COUNT: sparse enough
+// that a collision-free seed turns up within the first few dozen tried
+constexpr size_t slotsFor(size_t count) {
+    size_t slots = 1;
+    while (slots < 4 * count) slots <<= 1;
+    return slots;
+}
+inline constexpr size_t SLOTS = slotsFor(INSTRUCTION_COUNT);
+static_assert(INSTRUCTION_COUNT < 255, "Table stores an instruction index + 1 in a byte");
+
+constexpr uint32_t hash(std::string_view s, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : s) {
+        h ^= (uint8_t)c;
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+constexpr bool collisionFree(uint32_t seed) {
+    bool used[SLOTS] = {};
+    for (const InstructionDef& def : INSTRUCTION_SET) {
+        size_t slot = hash(def.mnemonic, seed) & (SLOTS - 1);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    for (uint32_t seed = 0; seed < 100000; seed++) {
+        if (collisionFree(seed)) return seed;
+    }
+    return ~0u;
+}
+
+inline constexpr uint32_t SEED = findSeed();
+static_assert(SEED != ~0u, "no collision-free seed for the mnemonic hash; make slotsFor() sparser");
+
+struct Table {
+    uint8_t slot[SLOTS];  // INSTRUCTION_SET index + 1, 0 = empty
+};
+
+constexpr Table buildTable() {
+    Table table = {};
+    for (size_t i = 0; i < INSTRUCTION_COUNT; i++) {
+        table.slot[hash(INSTRUCTION_SET[i].mnemonic, SEED) & (SLOTS - 1)] = (uint8_t)(i + 1);
+    }
+    return table;
+}
+
+inline constexpr Table TABLE = buildTable();
+
+}  // namespace instruction_hash
+
+// nullptr if the mnemonic is not in INSTRUCTION_SET
+constexpr const InstructionDef* findInstruction(std::string_view mnemonic) {
+    uint8_t entry = instruction_hash::TABLE.slot[instruction_hash::hash(mnemonic, instruction_hash::SEED) &
+                                                 (instruction_hash::SLOTS - 1)];
+    if (entry == 0 || INSTRUCTION_SET[entry - 1].mnemonic != mnemonic) return nullptr;
+    return &INSTRUCTION_SET[entry - 1];
+}
+
+static_assert(findInstruction("slli")->funct3 == 0x1, "mnemonic lookup");  // Not constant if the lookup fails
+
+#endif
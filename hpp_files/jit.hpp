@@ -0,0 +1,45 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include "block_cache.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// Native code for hot functional blocks (x86-64 Linux hosts only). A block is
+// compiled from its ThreadedOps into one host function: the guest register file
+// stays in memory behind a pointer pinned in rbx, ALU ops work on it directly,
+// loads and stores call into SparseMemory, and the branch picks the next pc with
+// a conditional move. Compiled code lives in a W^X arena: writable while a block
+// is emitted, executable otherwise.
+//
+// Everywhere else compile() returns nullptr and run_jit() keeps interpreting, as
+// it also does once the arena is full or the host refuses executable memory.
+class JitCache {
+public:
+    static constexpr uint32_t HOT_RUNS = 16;          // Interpreted runs before a block is compiled
+    static constexpr size_t   CODE_BYTES = 16 << 20;  // Arena size
+
+    static bool supported();  // Built for a host this can generate code for
+
+    JitCache() = default;
+    ~JitCache();
+    // Compiled code belongs to the blocks of one simulator, so a copy starts out empty
+    JitCache(const JitCache&) {}
+    JitCache& operator=(const JitCache&) { clear(); return *this; }
+
+    // Host code for `block`, or nullptr if it cannot be compiled
+    NativeBlock compile(const TranslatedBlock& block);
+
+    // Forgets all compiled code. The blocks pointing at it must be dropped too.
+    void clear();
+
+    size_t compiled_blocks() const { return blocks; }
+
+private:
+    uint8_t* code = nullptr;  // Arena, mapped on first use
+    size_t used = 0;
+    size_t blocks = 0;
+    bool unavailable = false; // Mapping or mprotect failed: stop trying
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef LOCKSTEP_HPP
+#define LOCKSTEP_HPP
+
+#include "simulator.hpp"
+#include <string>
+
+struct LockstepResult {
+    bool        ok;        // No divergence and the pipeline halted
+    bool        halted;
+    uint64_t    cycles;
+    uint64_t    retired;
+    std::string mismatch;  // First divergence (empty when ok)
+};
+
+// Steps `pipeline` cycle by cycle and, at every retirement, retires one
+// instruction on `reference` with step_functional(). Registers and the retired
+// IR are compared at every retirement and data memory whenever no store is in
+// flight between MEM and WB. Both simulators must be freshly loaded with the
+// same program and data. max_cycles = 0 runs until the pipeline halts.
+LockstepResult run_lockstep(RISCV_Simulator& pipeline, RISCV_Simulator& reference, uint64_t max_cycles = 0);
+
+struct JitCheckResult {
+    bool        ok;        // No divergence (and halted, unless max_instructions stopped it first)
+    bool        halted;
+    uint64_t    retired;
+    std::string mismatch;  // First divergence (empty when ok)
+};
+
+// Differential test of the JIT: runs `jit` with run_jit() and `reference` with
+// step_functional() in slices of `interval` instructions and compares pc, registers
+// and data memory after each. A slice of a few thousand lets hot blocks get
+// compiled and still narrows a divergence down to one slice. Both simulators must
+// be freshly loaded with the same program and data.
+JitCheckResult run_jit_check(RISCV_Simulator& jit, RISCV_Simulator& reference, uint64_t interval = 4096,
+                             uint64_t max_instructions = 0);
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+
+// Full 32-bit, byte-addressed, little-endian data memory.
+// Backed by 4 KiB pages that are allocated on first write through a two-level
+// table (1024 directories x 1024 pages). Untouched memory reads as zero.
+// Directories and pages are reference counted and shared copy-on-write with
+// snapshots: the first write to a shared page copies just that page.
+class SparseMemory {
+public:
+    static const uint32_t PAGE_BITS = 12;
+    static const uint32_t PAGE_SIZE = 1u << PAGE_BITS;  // 4 KiB
+    static const uint32_t DIR_BITS  = 10;
+    static const uint32_t DIR_SIZE  = 1u << DIR_BITS;   // Pages per directory
+
+private:
+    struct Page {
+        uint8_t bytes[PAGE_SIZE];
+    };
+    struct Directory {
+        std::shared_ptr<Page> pages[DIR_SIZE];
+    };
+
+    std::shared_ptr<Directory> dirs[DIR_SIZE];
+    size_t allocated_pages;
+
+    static uint32_t dir_index(uint32_t addr)  { return addr >> (PAGE_BITS + DIR_BITS); }
+    static uint32_t page_index(uint32_t addr) { return (addr >> PAGE_BITS) & (DIR_SIZE - 1); }
+    static uint32_t offset(uint32_t addr)     { return addr & (PAGE_SIZE - 1); }
+
+    // nullptr if the page was never written
+    const uint8_t* find_page(uint32_t addr) const {
+        const Directory* dir = dirs[dir_index(addr)].get();
+        if (!dir) return nullptr;
+        const Page* page = dir->pages[page_index(addr)].get();
+        return page ? page->bytes : nullptr;
+    }
+    uint8_t* page_for_write(uint32_t addr);
+
+public:
+    // Frozen view of the whole memory. Holds references to the pages, so taking
+    // one costs a copy of the top-level table whatever the amount of memory in use.
+    class Snapshot {
+    private:
+        friend class SparseMemory;
+        std::shared_ptr<Directory> dirs[DIR_SIZE];
+        size_t allocated_pages = 0;
+    };
+
+    SparseMemory() : allocated_pages(0) {}
+    SparseMemory(const SparseMemory&) = delete;
+    SparseMemory& operator=(const SparseMemory&) = delete;
+
+    uint8_t read8(uint32_t addr) const {
+        const uint8_t* page = find_page(addr);
+        return page ? page[offset(addr)] : 0;
+    }
+
+    void write8(uint32_t addr, uint8_t value) {
+        page_for_write(addr)[offset(addr)] = value;
+    }
+
+    uint16_t read16(uint32_t addr) const {
+        return (uint16_t)(read8(addr) | (read8(addr + 1) << 8));
+    }
+
+    void write16(uint32_t addr, uint16_t value) {
+        write8(addr, value & 0xFF);
+        write8(addr + 1, value >> 8);
+    }
+
+    // Word access: a single page lookup when the word does not straddle a page
+    uint32_t read32(uint32_t addr) const {
+        if (offset(addr) <= PAGE_SIZE - 4) {
+            const uint8_t* page = find_page(addr);
+            if (!page) return 0;
+            const uint8_t* p = page + offset(addr);
+            return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        }
+        return read8(addr) | (read8(addr + 1) << 8) | (read8(addr + 2) << 16) | ((uint32_t)read8(addr + 3) << 24);
+    }
+
+    void write32(uint32_t addr, uint32_t value) {
+        if (offset(addr) <= PAGE_SIZE - 4) {
+            uint8_t* p = page_for_write(addr) + offset(addr);
+            p[0] = value & 0xFF;
+            p[1] = (value >> 8) & 0xFF;
+            p[2] = (value >> 16) & 0xFF;
+            p[3] = (value >> 24) & 0xFF;
+            return;
+        }
+        for (int i = 0; i < 4; i++) write8(addr + i, (value >> (8 * i)) & 0xFF);
+    }
+
+    // Bulk copy in, one page lookup per page touched
+    void write_block(uint32_t addr, const uint8_t* data, size_t len);
+
+    // Loads a .word image (address -> value), coalescing contiguous words into block writes
+    void load_words(const std::map<unsigned int, int32_t>& words);
+
+    void clear();
+    size_t page_count() const { return allocated_pages; }
+
+    // The PAGE_SIZE bytes of the page holding addr, or nullptr if it was never written.
+    // Stays valid until the next write to that page (which may copy it off a snapshot),
+    // restore() or clear().
+    const uint8_t* page_data(uint32_t addr) const { return find_page(addr); }
+
+    Snapshot snapshot() const;
+    void restore(const Snapshot& snap);
+
+    // Visits allocated pages in ascending address order
+    void for_each_page(const std::function<void(uint32_t base, const uint8_t* bytes)>& visit) const;
+
+    // True if both memories hold the same bytes (unallocated pages count as zero).
+    // On a difference, *first_diff receives the lowest differing address.
+    bool equals(const SparseMemory& other, uint32_t* first_diff = nullptr) const;
+};
+
+#endif
@@ -4,10 +4,21 @@
 #include "assembler.hpp"
 #include "utils.hpp"
 
-vector<string> readAndPreprocess(const string& filename);
-map<string, unsigned int> buildSymbolTable(const vector<string>& lines);
-vector<ParsedInstruction> parseInstructions(const vector<string>& lines);
-bool validateInstructions(const vector<ParsedInstruction>& instructions);
-void parseDataSection(const vector<string>& lines);
+// The whole file (or pipe) as one string; throws std::runtime_error if it cannot be opened
+string readSourceFile(const string& filename);
+
+// Assembles a source in one pass: labels, .data words and instructions are read
+// off the text as it is scanned, and branches to labels not yet seen are patched
+// once the pass ends. Malformed lines, including unknown registers and immediates or
+// branch offsets that do not fit their field, throw std::invalid_argument naming the
+// line; an unknown mnemonic or label throws std::out_of_range.
+Program assembleProgram(string source);
+
+// Assembles a file in place through a read-only mapping (read into memory where
+// mmap is not available), streaming: pages already scanned are handed back to the
+// OS and Program::instructions is left empty, so peak memory is about the size of
+// the machine code and data image rather than of the text. For runs, not listings.
+// Throws like assembleProgram, and std::runtime_error if the file cannot be opened.
+Program assembleFile(const string& filename);
 
 #endif
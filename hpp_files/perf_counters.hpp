@@ -0,0 +1,34 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstdint>
+
+// Hardware-style event counters, updated by RISCV_Simulator::step()
+struct PerfCounters {
+    uint64_t cycles;
+    uint64_t instret;          // Instructions retired (left WB)
+
+    // RAW stall cycles in ID, attributed to the nearest conflicting producer
+    uint64_t raw_stalls_ex;    // Producer in EX (with forwarding: load-use only)
+    uint64_t raw_stalls_mem;   // Producer in MEM
+    uint64_t raw_stalls_wb;    // Producer in WB
+
+    uint64_t control_flushes;  // Mispredicted branches and jumps that flushed IF/ID and ID/EX
+    uint64_t bubbles;          // NOPs inserted by stalls plus latch slots cleared by flushes
+
+    uint64_t loads;            // Memory operations performed in MEM
+    uint64_t stores;
+    uint64_t branches;         // Branches and jumps resolved in EX
+    uint64_t muldiv;           // RV32M operations completed in EX
+
+    uint64_t ex_busy_stalls;   // Cycles ID and IF waited on a multi-cycle operation in EX
+
+    uint64_t icache_stall_cycles;  // Cycles IF waited on the I-cache
+    uint64_t dcache_stall_cycles;  // Cycles the pipeline was frozen on the D-cache
+
+    uint64_t raw_stalls() const { return raw_stalls_ex + raw_stalls_mem + raw_stalls_wb; }
+    double cpi() const { return instret ? (double)cycles / instret : 0.0; }
+    double ipc() const { return cycles ? (double)instret / cycles : 0.0; }
+};
+
+#endif
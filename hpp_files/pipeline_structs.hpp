@@ -8,6 +8,10 @@ struct IF_ID {
     uint32_t IR;      // Instruction Register
     uint32_t NPC;     // Next PC (PC + 4)
     uint32_t PC;      // Current PC (for display)
+
+    // Branch prediction made in IF
+    bool     PredTaken;
+    uint32_t PredTarget;
 };
 
 // ID/EX Latch
@@ -30,16 +34,22 @@ struct ID_EX {
     bool RegWrite;
     bool MemRead;
     bool MemWrite;
-    bool Branch;      // BEQ, BLT
+    bool Branch;      // Conditional branches
+    bool Jump;        // JAL, JALR
     uint8_t ALUOp;    // Custom codes for ALU control
+
+    // Branch prediction carried from IF, checked when the branch resolves in EX
+    bool     PredTaken;
+    uint32_t PredTarget;
 };
 
 // EX/MEM Latch
 struct EX_MEM {
     uint32_t IR;
     int32_t  ALUOutput;
-    uint32_t B;       // Value to store (SW)
-    bool     cond;    // ALU condition (Zero/Less Than)
+    uint32_t B;       // Value to store
+    bool     cond;    // Branch condition
+    uint8_t  func3;   // Width (and sign extension) of the load or store
     
     // Pass-through Controls
     uint8_t  rd;
@@ -60,4 +70,15 @@ struct MEM_WB {
     bool     RegWrite;
 };
 
-#endif
\ No newline at end of file
+// The latch fields a front end displays, flattened to 32-bit words so the whole
+// set can be read as one array (signed fields are stored as their bit pattern).
+struct LatchWords {
+    uint32_t if_id_pc, if_id_ir, if_id_npc;
+    uint32_t id_ex_ir, id_ex_a, id_ex_b, id_ex_imm, id_ex_npc;
+    uint32_t ex_mem_ir, ex_mem_aluoutput, ex_mem_b, ex_mem_cond;
+    uint32_t mem_wb_ir, mem_wb_aluoutput, mem_wb_lmd, mem_wb_rd, mem_wb_regwrite;
+};
+static const unsigned LATCH_WORDS = sizeof(LatchWords) / sizeof(uint32_t);
+static_assert(LATCH_WORDS == 17, "LatchWords must stay a packed array of words");
+
+#endif
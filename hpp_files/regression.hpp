@@ -0,0 +1,62 @@
+#ifndef REGRESSION_HPP
+#define REGRESSION_HPP
+
+#include "sim_config.hpp"
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Golden-state regression cases. A corpus file holds one or more programs; a new
+// case starts at a column-0 comment that opens the file or follows a blank line,
+// and that comment is the case's title:
+//
+//   # Load-Use Hazard
+//   .data
+//   ...
+//   # expect: x1=42 x2=0 mem[4]=0 cycles=9
+//
+// `# expect:` lines (anywhere in the case, indented or not) list whitespace-separated checks on the
+// final state: xN=<value> (or an ABI name such as a0=<value>) for a register, mem[<addr>]=<value> for a data word,
+// cycles=<n> and instret=<n>. Values are decimal or 0x hex. Cycle counts are exact:
+// any difference fails, and more cycles than expected is reported as a regression.
+// Lines before the first title form a case named after the file.
+//
+// `# rewrite: cycle=<n> <addr>=<word> ...` lines change instruction words (set_instruction)
+// once the pipeline has run n cycles, for cases about code rewritten while it is in flight.
+struct RegressionCase {
+    std::string file;
+    unsigned    line;       // Line of the title (1-based)
+    std::string name;
+    std::string source;     // The case's lines, annotations included (they are comments)
+
+    std::map<int, int32_t>       regs;
+    std::map<uint32_t, uint32_t> mem;
+    bool     check_cycles  = false;
+    uint64_t cycles        = 0;
+    bool     check_instret = false;
+    uint64_t instret       = 0;
+
+    std::multimap<uint64_t, std::pair<uint32_t, uint32_t>> rewrites;  // cycle -> (address, word), in file order
+};
+
+// Splits a corpus into cases. false (with a message naming the line) on a malformed annotation.
+bool splitCorpus(std::istream& in, const std::string& file, std::vector<RegressionCase>& cases, std::string& error);
+
+struct RegressionResult {
+    bool        passed;
+    bool        cycle_regression;  // Took more cycles than its annotation
+    bool        halted;
+    uint64_t    cycles;
+    uint64_t    instret;
+    std::string failures;          // One "; "-separated entry per failed check
+};
+
+// Assembles and runs one case to completion (or max_cycles; 0 = no limit) and checks it.
+// A case that does not assemble fails with the assembler's message.
+// check_cycles = false skips the cycle check, for configs the annotations were not written for.
+RegressionResult runRegressionCase(const RegressionCase& c, const SimulatorConfig& config,
+                                   uint64_t max_cycles = 0, bool check_cycles = true);
+
+#endif
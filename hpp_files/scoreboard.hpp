@@ -0,0 +1,35 @@
+#ifndef SCOREBOARD_HPP
+#define SCOREBOARD_HPP
+
+#include <cstdint>
+#include <cstring>
+
+// Register scoreboard for RAW hazard detection in ID. Each architectural register
+// remembers its newest in-flight producer: when a consumer may use the value, and
+// when the producer reaches WB. Times are in pipeline cycles, which stop along with
+// every stage while the pipeline is frozen, so a producer of any latency is checked
+// with one lookup per source register instead of one comparison per stage.
+class Scoreboard {
+public:
+    struct Entry {
+        uint64_t ready;  // First cycle a consumer may leave ID (0: nothing in flight)
+        uint64_t wb;     // Cycle the producer is in WB
+    };
+
+    Scoreboard() { clear(); }
+    void clear() { std::memset(entries, 0, sizeof(entries)); }
+
+    // Records the producer ID issues this cycle; writes to x0 are not tracked
+    void issue(uint8_t rd, uint64_t ready, uint64_t wb) {
+        if (rd != 0) entries[rd] = {ready, wb};
+    }
+
+    bool busy(uint8_t reg, uint64_t now) const { return entries[reg].ready > now; }
+    const Entry& operator[](uint8_t reg) const { return entries[reg]; }
+    Entry& operator[](uint8_t reg) { return entries[reg]; }
+
+private:
+    Entry entries[32];
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include "assembler.hpp"
+#include "simulator.hpp"
+
+// One program and the simulator running it. A session shares nothing mutable with
+// any other, so separate sessions can be assembled and run on separate threads
+// (one thread per session at a time).
+class Session {
+private:
+    Program program;
+    RISCV_Simulator sim;
+    RISCV_Simulator::Snapshot initial;   // Right after the data image was loaded
+
+public:
+    explicit Session(Program prog, const SimulatorConfig& config = SimulatorConfig());
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    const Program& get_program() const { return program; }
+    RISCV_Simulator& simulator() { return sim; }
+    const RISCV_Simulator& simulator() const { return sim; }
+
+    // Back to the freshly loaded state (memory pages are shared, not reloaded)
+    void reset() { sim.restore(initial); }
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SIM_CONFIG_HPP
+#define SIM_CONFIG_HPP
+
+#include "branch_predictor.hpp"
+#include "cache.hpp"
+#include <string>
+
+// Microarchitecture options fixed when a RISCV_Simulator is constructed.
+// The defaults reproduce the original stall-only pipeline.
+struct SimulatorConfig {
+    bool forwarding = false;   // EX/MEM->EX and MEM/WB->EX bypass (load-use still stalls 1 cycle)
+
+    PredictorKind predictor = PredictorKind::NotTaken;
+    unsigned bht_entries = 64;  // 2-bit counters in the BHT
+    unsigned btb_entries = 16;  // Direct-mapped BTB entries
+
+    CacheConfig icache;         // L1 caches, both off by default (single-cycle fetch and MEM)
+    CacheConfig dcache;
+
+    // RV32M in EX. The multiplier is pipelined: a MUL* result can be forwarded
+    // mul_latency cycles after it enters EX and another one may follow right behind
+    // (beyond 3 cycles it holds EX for the rest, as the result must be there by WB).
+    // The divider is iterative: a DIV*/REM* holds EX for all div_latency cycles.
+    unsigned mul_latency = 3;
+    unsigned div_latency = 32;
+};
+
+// Applies one "key=value" option (e.g. "forwarding=1", "predictor=bht", "bht_entries=128"). Returns false and sets
+// `error` for an unknown key or a malformed value.
+// Cache keys are icache / dcache (enable) and icache_<field> / dcache_<field> with field one of
+// size, ways, line, policy (lru|fifo|random), write (back|through), hit_latency, miss_latency.
+bool applySimulatorOption(SimulatorConfig& config, const std::string& key, const std::string& value, std::string& error);
+
+// Applies a comma-separated option list such as "forwarding=1". A bare key means "=1".
+bool parseSimulatorOptions(const std::string& options, SimulatorConfig& config, std::string& error);
+
+// Checks the options that depend on each other (cache geometry). Returns false and sets `error` if unusable.
+bool validateSimulatorConfig(const SimulatorConfig& config, std::string& error);
+
+// The option list that reproduces `config`
+std::string describeSimulatorConfig(const SimulatorConfig& config);
+
+#endif
@@ -3,21 +3,94 @@
 
 #include "assembler.hpp"
 #include "pipeline_structs.hpp"
+#include "decoder.hpp"
+#include "branch_predictor.hpp"
+#include "sim_config.hpp"
+#include "memory.hpp"
+#include "cache.hpp"
+#include "perf_counters.hpp"
+#include "trace.hpp"
+#include "history.hpp"
+#include "block_cache.hpp"
+#include "jit.hpp"
+#include "scoreboard.hpp"
+#include <deque>
 #include <map>
+#include <vector>
 #include <cstring>
 
 class RISCV_Simulator {
+public:
+    // Everything step() and step_functional() can change, captured between cycles.
+    // Memory pages are shared copy-on-write, so a snapshot costs the same however
+    // much memory is in use. Only restore into the simulator it was taken from (or
+    // one built from the same program and config).
+    struct Snapshot {
+        int32_t registers[32];
+        SparseMemory::Snapshot memory;
+        uint32_t pc;
+        uint64_t cycle;
+        PerfCounters counters;
+        bool stall_pipeline;
+        Scoreboard scoreboard;
+        BranchPredictor predictor;
+        Cache icache, dcache;
+        uint32_t fetch_pc;
+        bool fetch_pending;
+        unsigned fetch_wait;
+        bool mem_pending;
+        unsigned mem_wait;
+        bool ex_pending;
+        unsigned ex_wait;
+        IF_ID  if_id,  if_id_next;
+        ID_EX  id_ex,  id_ex_next;
+        EX_MEM ex_mem, ex_mem_next;
+        MEM_WB mem_wb, mem_wb_next;
+    };
+
 private:
     // --- Architectural State ---
     int32_t registers[32];
-    uint8_t data_memory[128]; // 0x00-0x7F
+    SparseMemory data_memory; // Full 32-bit address space, 4 KiB pages
     
-    // Reference to Instruction Memory (From your assembler)
-    std::map<unsigned int, unsigned int>& inst_memory;
+    // Instruction Memory, predecoded once at load.
+    // Slot (pc - INSTRUCTION_MEMORY_START) >> 2; IR == 0 marks an empty slot.
+    std::vector<DecodedInst> program;
+    BlockCache block_cache;   // run_functional()'s translations of `program`
+    JitCache jit;             // Host code for the hot ones (run_jit())
     
     uint32_t pc;
     uint64_t cycle;
+    PerfCounters counters;  // cycles is filled in from `cycle` by get_counters()
     bool stall_pipeline; // Global stall flag
+    Scoreboard scoreboard; // Pending register writes, for hazard detection in ID
+
+    SimulatorConfig config;
+    BranchPredictor predictor;
+
+    // --- L1 Caches (timing only; data always comes from data_memory) ---
+    Cache icache;
+    Cache dcache;
+    uint32_t fetch_pc;     // PC of the fetch the I-cache is working on
+    bool fetch_pending;
+    unsigned fetch_wait;   // Cycles left before that fetch completes
+    bool mem_pending;      // The access in EX/MEM has been sent to the D-cache
+    unsigned mem_wait;     // Cycles left before it completes
+
+    // --- Multi-cycle EX (RV32M) ---
+    bool ex_pending;       // The instruction in ID/EX has started a multi-cycle operation
+    unsigned ex_wait;      // Cycles left before it leaves EX
+
+    // --- Reverse execution (off until enable_history()) ---
+    DeltaJournal journal;                  // One undo record per step(), newest last
+    std::deque<Snapshot> history_snapshots; // Every snapshot_interval cycles, oldest first
+    uint64_t snapshot_interval;            // 0 = history off
+    size_t max_snapshots;
+    CycleDelta* recording;                 // Undo record the current step() fills, or nullptr
+
+    // --- Tracing ---
+    TraceLevel trace_level;
+    TraceSink* trace_sink;
 
     // --- Pipeline Registers (Double Buffered) ---
     IF_ID  if_id,  if_id_next;
@@ -26,26 +99,134 @@ private:
     MEM_WB mem_wb, mem_wb_next;
 
     // Internal Helpers
-    int32_t sign_extend(uint32_t inst, int type); // 0=I, 1=S, 2=B, 3=J
+    const DecodedInst* program_slot(uint32_t addr) const {
+        uint32_t idx = (addr - INSTRUCTION_MEMORY_START) >> 2;
+        if ((addr & 0x3) || idx >= program.size() || program[idx].ctrl.IR == 0) return nullptr;
+        return &program[idx];
+    }
+
+    // The scoreboard's clock: cycles in which the pipeline moved (a D-cache wait freezes every stage)
+    uint64_t pipeline_clock() const { return cycle - counters.dcache_stall_cycles; }
+
+    // EX cycles an instruction holds the stage, and cycles from entering EX until
+    // its result can be forwarded (a load's comes out of MEM)
+    unsigned ex_occupancy(const ID_EX& c) const {
+        if (is_divide(c)) return config.div_latency;
+        if (is_muldiv(c)) return config.mul_latency > 3 ? config.mul_latency - 2 : 1;
+        return 1;
+    }
+    unsigned result_latency(const ID_EX& c) const {
+        if (is_divide(c)) return config.div_latency;
+        if (is_muldiv(c)) return config.mul_latency;
+        return c.MemRead ? 2 : 1;
+    }
+
+    // One cycle; Tracing=false compiles every trace statement out
+    template <bool Tracing> void step_impl();
+
+    // run_functional() (Native=false) and run_jit()
+    template <bool Native> uint64_t run_blocks(uint64_t max_instructions);
+
+    void step_recorded();       // step() with an undo record pushed onto the journal
+    void undo_cycle();          // Pops the newest undo record and applies it
+    void restore_state(const Snapshot& snap);
+    void reset_history();       // Drops recorded history; it restarts at the current cycle
 
 public:
-    RISCV_Simulator(std::map<unsigned int, unsigned int>& imem);
+    // code: encoded instructions, one word per address from INSTRUCTION_MEMORY_START
+    RISCV_Simulator(const std::vector<uint32_t>& code,
+                    const SimulatorConfig& cfg = SimulatorConfig());
 
     // Core Execution
     void step();     // Execute 1 Cycle
-    void run();      // Run until end
+    uint64_t run(uint64_t max_cycles = 0);  // Step until halted or max_cycles (0 = no limit); returns cycles run
+
+    // Functional mode: retire the instruction at pc in one go (no pipeline timing).
+    // Use on a simulator that is not also being stepped with step(). run_functional()
+    // goes a basic block at a time through the block cache (block_cache.hpp).
+    bool step_functional();                                // false once pc leaves the program
+    uint64_t run_functional(uint64_t max_instructions = 0); // 0 = until halted; returns count
+    size_t get_translated_blocks() const { return block_cache.size(); }
+
+    // run_functional() with blocks compiled to host code once they have run
+    // JitCache::HOT_RUNS times (jit.hpp). Where the JIT is not available this
+    // is exactly run_functional().
+    uint64_t run_jit(uint64_t max_instructions = 0);
+    size_t get_compiled_blocks() const { return jit.compiled_blocks(); }
+
+    // Checkpointing. restore() also serves as an instant reset to a snapshot taken after load.
+    Snapshot snapshot() const;
+    void restore(const Snapshot& snap);
+
+    // Reverse execution of step(). While enabled, every cycle pushes an undo record onto a
+    // ring of `journal_cycles` entries and every `snapshot_interval` cycles a snapshot is kept
+    // (at most `max_snapshots`). Stepping back undoes records one by one; seeks further than
+    // that replay forward from the nearest earlier snapshot instead. Changing state by hand
+    // (set_reg, set_memory, restore, step_functional) restarts the history at that point.
+    void enable_history(size_t journal_cycles = 16384, uint64_t snapshot_interval = 1024, size_t max_snapshots = 64);
+    void disable_history();
+    bool history_enabled() const { return snapshot_interval != 0; }
+    uint64_t get_history_start() const;  // Earliest cycle seek_to_cycle() can reach
+    bool step_back(uint64_t n = 1);      // false (and nothing changes) if history does not reach
+    bool seek_to_cycle(uint64_t target); // Forward seeks just step()
+
+    // Trace output (defaults to Full on std::cout). A null sink selects std::cout.
+    void set_trace(TraceLevel level, TraceSink* sink = nullptr);
+    TraceLevel get_trace_level() const { return trace_level; }
     
     // Getters for GUI/Console Output
     uint32_t get_pc() const { return pc; }
+    const SimulatorConfig& get_config() const { return config; }
+    const PredictorStats& get_predictor_stats() const { return predictor.get_stats(); }
+    const CacheStats& get_icache_stats() const { return icache.get_stats(); }
+    const CacheStats& get_dcache_stats() const { return dcache.get_stats(); }
+    uint64_t get_cycle() const { return cycle; }
+    uint64_t get_retired() const { return counters.instret; }  // Also counts step_functional()
+    PerfCounters get_counters() const {
+        PerfCounters c = counters;
+        c.cycles = cycle;
+        return c;
+    }
+    uint32_t get_instruction(uint32_t addr) const {  // 0 if there is none
+        const DecodedInst* slot = program_slot(addr);
+        return slot ? slot->ctrl.IR : 0;
+    }
+    // Rewrites the instruction at addr (which must lie in the loaded program; false
+    // otherwise) and drops the translated blocks. A write of 0 empties the slot. An
+    // instruction already fetched from addr carries on through the pipeline as fetched.
+    bool set_instruction(uint32_t addr, uint32_t word);
     int32_t get_reg(int idx) const { return registers[idx]; }
-    uint8_t get_mem(int addr) const { return data_memory[addr]; }
+    uint8_t get_mem(uint32_t addr) const { return data_memory.read8(addr); }
+    uint32_t get_mem_word(uint32_t addr) const { return data_memory.read32(addr); }
+    const SparseMemory& get_memory() const { return data_memory; }
+    // The 32 registers in place; the pointer is fixed for the simulator's lifetime
+    const int32_t* register_file() const { return registers; }
+    const uint8_t* memory_page(uint32_t addr) const { return data_memory.page_data(addr); }
+
+    // True once fetch has run past the program and every latch has drained
+    bool is_halted() const {
+        return !program_slot(pc) &&
+               if_id.IR == 0 && id_ex.IR == 0 && ex_mem.IR == 0 && mem_wb.IR == 0;
+    }
 
     void set_reg(int idx, int32_t val) {
         if (idx > 0 && idx < 32) registers[idx] = val;
+        if (history_enabled()) reset_history();
     }
 
-    void set_memory(int addr, uint8_t val) {
-        if (addr >= 0 && addr < 128) data_memory[addr] = val;
+    void set_memory(uint32_t addr, uint8_t val) {
+        data_memory.write8(addr, val);
+        if (history_enabled()) reset_history();
+    }
+    void set_memory_word(uint32_t addr, uint32_t val) {
+        data_memory.write32(addr, val);
+        if (history_enabled()) reset_history();
+    }
+
+    // Bulk-loads an initial data image (address -> .word value)
+    void load_data(const std::map<unsigned int, int32_t>& words) {
+        data_memory.load_words(words);
+        if (history_enabled()) reset_history();
     }
     
     // Access to internal pipeline state for display
@@ -53,6 +234,25 @@ public:
     ID_EX  get_id_ex()  { return id_ex; }
     EX_MEM get_ex_mem() { return ex_mem; }
     MEM_WB get_mem_wb() { return mem_wb; }
+    void get_latch_words(LatchWords& out) const {
+        out.if_id_pc = if_id.PC;
+        out.if_id_ir = if_id.IR;
+        out.if_id_npc = if_id.NPC;
+        out.id_ex_ir = id_ex.IR;
+        out.id_ex_a = id_ex.A;
+        out.id_ex_b = id_ex.B;
+        out.id_ex_imm = (uint32_t)id_ex.IMM;
+        out.id_ex_npc = id_ex.NPC;
+        out.ex_mem_ir = ex_mem.IR;
+        out.ex_mem_aluoutput = (uint32_t)ex_mem.ALUOutput;
+        out.ex_mem_b = ex_mem.B;
+        out.ex_mem_cond = ex_mem.cond;
+        out.mem_wb_ir = mem_wb.IR;
+        out.mem_wb_aluoutput = (uint32_t)mem_wb.ALUOutput;
+        out.mem_wb_lmd = (uint32_t)mem_wb.LMD;
+        out.mem_wb_rd = mem_wb.rd;
+        out.mem_wb_regwrite = mem_wb.RegWrite;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef STEP_BATCH_HPP
+#define STEP_BATCH_HPP
+
+#include "simulator.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Runs several cycles and packs what each one changed into 32-bit little-endian
+// words, so a front end pays one call (one JS/Wasm crossing) per batch.
+//
+//   out[0]            number of records that follow
+//   per record:
+//     [0]             cycle (low 32 bits)
+//     [1]             pc after the cycle
+//     [2..18]         LatchWords (pipeline_structs.hpp):
+//                     if_id pc, ir, npc; id_ex ir, a, b, imm, npc;
+//                     ex_mem ir, aluoutput, b, cond; mem_wb ir, aluoutput, lmd, rd, regwrite
+//     [19]            bit 0: halted after this cycle; bits 8-15: R; bits 16-23: M
+//     then R pairs    (register index, new value) for registers written this cycle
+//     then M pairs    (word address, new value) for memory words stored this cycle;
+//                     a byte or halfword store reports the whole aligned word it changed
+static const size_t STEP_BATCH_RECORD_WORDS = 20;  // Fixed part of a record
+
+// Steps up to max_cycles (fewer if the program halts) and replaces out with the
+// records. Returns the number of cycles run.
+size_t step_batch(RISCV_Simulator& sim, size_t max_cycles, std::vector<uint32_t>& out);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum class TraceLevel : uint8_t {
+    Off,        // No output; the untraced step() is compiled without any trace code
+    Summary,    // One line per cycle
+    Full,       // Per-stage narration ("[WB] Wrote ...", "[IF] Fetched ...")
+    Structured  // One JSON object per cycle (JSON Lines)
+};
+
+// End-of-cycle view of the pipeline handed to the sink
+struct CycleTrace {
+    uint64_t cycle;
+    uint32_t pc;          // PC after this cycle's fetch
+    uint32_t if_id_ir;
+    uint32_t id_ex_ir;
+    uint32_t ex_mem_ir;
+    uint32_t mem_wb_ir;
+    bool     data_stall;  // ID inserted a bubble for a RAW hazard
+    bool     ex_busy;     // A multi-cycle operation held EX (ID and IF waited, MEM got a bubble)
+    bool     flush;       // EX redirected fetch and flushed IF/ID, ID/EX
+    bool     icache_wait; // IF is waiting on the I-cache (IF/ID holds a bubble)
+    bool     dcache_wait; // MEM is waiting on the D-cache (whole pipeline frozen)
+};
+
+// Receives simulator trace output. Implement this to capture or redirect it.
+class TraceSink {
+public:
+    virtual ~TraceSink() {}
+
+    // Stream for the free-form stage narration written at TraceLevel::Full
+    virtual std::ostream& text() = 0;
+
+    // Called at the end of every traced cycle, whatever the level
+    virtual void end_cycle(TraceLevel level, const CycleTrace& trace) = 0;
+};
+
+// Formats every level onto a std::ostream
+class StreamTraceSink : public TraceSink {
+private:
+    std::ostream& out;
+
+public:
+    explicit StreamTraceSink(std::ostream& os) : out(os) {}
+
+    std::ostream& text() override { return out; }
+    void end_cycle(TraceLevel level, const CycleTrace& trace) override;
+};
+
+// Shared sink writing to std::cout (the browser console under Emscripten)
+TraceSink& consoleTraceSink();
+
+// "off" / "summary" / "full" / "structured"; returns false for anything else
+bool parseTraceLevel(const std::string& name, TraceLevel& level);
+
+#endif
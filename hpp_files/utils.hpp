@@ -2,10 +2,10 @@
 #define UTILS_HPP
 
 #include "assembler.hpp"
+#include <string_view>
 
-unsigned int binToUint(const string& bin);
-int getRegisterNumber(const string& reg);
-int getImmediateValue(const string& immStr);
-vector<string> split(const string& s, char delimiter);
+int getRegisterNumber(string_view reg);   // "x0".."x31" or an ABI name ("zero", "ra", "sp", "a0", "fp", ...), -1 otherwise
+bool parseImmediate(string_view immStr, int& value);   // Decimal or 0x hex; false if immStr is not a number
+int getImmediateValue(string_view immStr);              // parseImmediate's value, 999999999 if it fails
 
 #endif
@@ -0,0 +1,108 @@
+// Background runner: a second copy of the simulator module in a dedicated worker,
+// so long runs go at full speed while the page stays responsive.
+//
+// Page -> worker:
+//   { cmd: 'init', code, options }   assemble and load (replaces any previous program)
+//   { cmd: 'run', progressMs }       run (or resume) until halted, pause or stop;
+//                                    a progress message every progressMs milliseconds
+//   { cmd: 'pause' }                 stop after the current slice and keep the state
+//   { cmd: 'stop' }                  cancel the run and go back to the loaded state
+//
+// Worker -> page:
+//   { type: 'ready' }                            module loaded
+//   { type: 'initialized', result }              initializeSimulatorWithOptions() result
+//   { type: 'progress' | 'paused' | 'stopped' | 'halted', ...state }
+//   { type: 'error', message }
+// where state is { cycles, cyclesPerSecond, pc, registers (Int32Array copy), counters }.
+
+var Module = {
+    onRuntimeInitialized: function() {
+        postMessage({ type: 'ready' });
+    },
+};
+importScripts('simulator.js');
+
+const SLICE_TARGET_MS = 10;  // Length of one runCycles() call; commands are handled between slices
+let sliceCycles = 4096;      // Adapted to SLICE_TARGET_MS as the run goes
+let running = false;
+let progressMs = 250;
+let lastProgressTime = 0;
+let lastProgressCycles = 0;
+
+// Messages posted to ourselves run after any queued commands (setTimeout would be clamped to 4ms)
+const yieldChannel = new MessageChannel();
+yieldChannel.port1.onmessage = runSlice;
+
+function report(type) {
+    const now = performance.now();
+    const counters = Module.getPerfCounters();
+    const elapsed = (now - lastProgressTime) / 1000;
+    const ran = counters.cycles - lastProgressCycles;  // Negative after a stop
+    const cyclesPerSecond = elapsed > 0 && ran > 0 ? ran / elapsed : 0;
+    lastProgressTime = now;
+    lastProgressCycles = counters.cycles;
+    postMessage({
+        type: type,
+        cycles: counters.cycles,
+        cyclesPerSecond: cyclesPerSecond,
+        pc: Module.getPC() >>> 0,
+        registers: Module.getRegisterView().slice(), // Copy: the view cannot leave the worker
+        counters: counters,
+    });
+}
+
+function runSlice() {
+    if (!running) return;
+
+    const start = performance.now();
+    const ran = Module.runCycles(sliceCycles);
+    const took = performance.now() - start;
+    if (took > 0 && ran === sliceCycles) {
+        sliceCycles = Math.max(256, Math.min(1 << 22, Math.round(sliceCycles * SLICE_TARGET_MS / took)));
+    }
+
+    if (Module.isHalted()) {
+        running = false;
+        report('halted');
+        return;
+    }
+    if (performance.now() - lastProgressTime >= progressMs) report('progress');
+    yieldChannel.port2.postMessage(null);
+}
+
+onmessage = function(e) {
+    const msg = e.data;
+    try {
+        switch (msg.cmd) {
+        case 'init': {
+            running = false;
+            Module.setTraceLevel('off'); // Nobody reads the narration: runCycles must not format it
+            const result = Module.initializeSimulatorWithOptions(msg.code, msg.options || '');
+            Module.setHistoryEnabled(false); // Nothing steps back in here
+            postMessage({ type: 'initialized', result: result });
+            break;
+        }
+        case 'run':
+            if (running) break;
+            if (msg.progressMs > 0) progressMs = msg.progressMs;
+            running = true;
+            lastProgressTime = performance.now();
+            lastProgressCycles = Module.getPerfCounters().cycles;
+            yieldChannel.port2.postMessage(null);
+            break;
+        case 'pause':
+            if (!running) break;
+            running = false;
+            report('paused');
+            break;
+        case 'stop':
+            running = false;
+            Module.resetSimulator();
+            report('stopped');
+            break;
+        }
+    } catch (err) {
+        running = false;
+        postMessage({ type: 'error', message: err.message });
+    }
+};
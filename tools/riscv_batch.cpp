@@ -0,0 +1,165 @@
+// Thread-pool driver: assembles and runs every .s program in a directory (or the
+// files given) to completion, one Session per program, spread over all cores.
+// Prints one line per program in input order, then the aggregate throughput.
+//   exit 0: all halted   1: a program could not be assembled   2: a program hit --max-cycles
+#include "../hpp_files/assembler.hpp"
+#include "../hpp_files/parser.hpp"
+#include "../hpp_files/session.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options] <dir | program.s ...>\n"
+         << "Options:\n"
+         << "  -j <n>              worker threads (default: one per core)\n"
+         << "  --max-cycles <n>    stop each program after n cycles (default: run until halted)\n"
+         << "  --repeat <n>        run every program n times (default 1), for steadier numbers\n"
+         << "  any riscv_cli pipeline option (--forwarding, --predictor=..., --icache, ...)\n";
+}
+
+struct Job {
+    string   filename;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    bool     halted = false;
+    double   seconds = 0;   // Simulation only, assembly excluded
+    string   error;         // Why the program did not run (it did not assemble); empty otherwise
+
+    explicit Job(string file) : filename(std::move(file)) {}
+};
+
+static void runJob(Job& job, const SimulatorConfig& config, uint64_t maxCycles, unsigned repeat) {
+    // One bad program fails on its own; the rest of the pool carries on
+    Program program;
+    try {
+        program = assembleFile(job.filename);
+    } catch (const std::exception& e) {
+        job.error = e.what();
+        return;
+    }
+
+    Session session(std::move(program), config);
+    RISCV_Simulator& sim = session.simulator();
+    sim.set_trace(TraceLevel::Off);
+
+    auto start = chrono::steady_clock::now();
+    for (unsigned r = 0; r < repeat; r++) {
+        if (r != 0) session.reset();
+        job.cycles += sim.run(maxCycles);
+        job.instructions += sim.get_retired();
+    }
+    job.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    job.halted = sim.is_halted();
+}
+
+int main(int argc, char** argv) {
+    vector<string> inputs;
+    unsigned threads = thread::hardware_concurrency();
+    uint64_t maxCycles = 0;
+    unsigned repeat = 1;
+    SimulatorConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if ((arg == "-j" || arg == "--max-cycles" || arg == "--repeat") && i + 1 < argc) {
+            string value = argv[++i];
+            try {
+                // Like sim_config's counts: digits only, as stoul would stop at the first other character
+                if (value.find_first_not_of("0123456789") != string::npos) throw invalid_argument(value);
+                if (arg == "-j") threads = (unsigned)stoul(value);
+                else if (arg == "--max-cycles") maxCycles = stoull(value);
+                else repeat = (unsigned)stoul(value);
+            } catch (const std::exception&) {
+                cerr << "ERROR: Invalid value '" << value << "' for " << arg << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            string key = arg.substr(2, eq == string::npos ? string::npos : eq - 2);
+            string value = (eq == string::npos) ? "1" : arg.substr(eq + 1);
+            string error;
+            if (!applySimulatorOption(config, key, value, error)) {
+                cerr << "ERROR: " << error << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            cerr << "ERROR: Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    string configError;
+    if (!validateSimulatorConfig(config, configError)) {
+        cerr << "ERROR: " << configError << endl;
+        return 1;
+    }
+
+    // A directory contributes its .s files, sorted so the output order is stable
+    vector<Job> jobs;
+    for (const string& input : inputs) {
+        if (!filesystem::is_directory(input)) {
+            jobs.emplace_back(input);
+            continue;
+        }
+        vector<string> found;
+        for (const auto& entry : filesystem::directory_iterator(input)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".s") found.push_back(entry.path().string());
+        }
+        sort(found.begin(), found.end());
+        for (const string& f : found) jobs.emplace_back(f);
+    }
+    if (jobs.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+    if (repeat == 0) repeat = 1;
+    if (threads > jobs.size()) threads = (unsigned)jobs.size();
+
+    // Workers claim the next unstarted job until none are left
+    atomic<size_t> next(0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&]() {
+            for (size_t i = next++; i < jobs.size(); i = next++) runJob(jobs[i], config, maxCycles, repeat);
+        });
+    }
+    for (thread& worker : pool) worker.join();
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t totalCycles = 0, totalInstructions = 0;
+    double busy = 0;
+    int exitCode = 0;
+    for (const Job& job : jobs) {
+        if (!job.error.empty()) {
+            cout << job.filename << ": ERROR: " << job.error << "\n";
+            exitCode = 1;
+            continue;
+        }
+        cout << job.filename << ": " << job.cycles << " cycles, " << job.instructions << " instructions"
+             << (job.halted ? "" : " (limit reached)") << "\n";
+        totalCycles += job.cycles;
+        totalInstructions += job.instructions;
+        busy += job.seconds;
+        if (!job.halted && exitCode == 0) exitCode = 2;
+    }
+
+    cout << fixed << setprecision(3)
+         << "programs: " << jobs.size() << " (x" << repeat << ")  threads: " << threads << "  wall: " << wall * 1000.0 << " ms\n"
+         << setprecision(0)
+         << "throughput: " << (wall > 0 ? totalCycles / wall : 0) << " cycles/s, "
+         << (wall > 0 ? totalInstructions / wall : 0) << " instructions/s"
+         << " (" << (busy > 0 ? totalCycles / busy : 0) << " cycles/s per thread)\n";
+    return exitCode;
+}
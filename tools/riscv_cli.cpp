@@ -0,0 +1,240 @@
+// Native headless driver: assembles each .s file, runs it to completion on the
+// pipelined simulator and writes the final register and memory state.
+#include "../hpp_files/assembler.hpp"
+#include "../hpp_files/parser.hpp"
+#include "../hpp_files/session.hpp"
+#include "../hpp_files/lockstep.hpp"
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options] <program.s> [more.s ...]\n"
+         << "Options:\n"
+         << "  -o <file>           write the final state to <file> instead of stdout\n"
+         << "  --max-cycles <n>    stop after n cycles, or n instructions with --functional / --jit\n"
+         << "                      (default: run until halted)\n"
+         << "  --trace=<level>     off (default), summary, full or structured\n"
+         << "  --functional        ISA-level execution, one instruction per step (no pipeline timing)\n"
+         << "  --lockstep          run the pipeline and the functional model side by side and\n"
+         << "                      compare architectural state at every retirement\n"
+         << "  --jit               --functional with hot blocks compiled to host code (x86-64 Linux;\n"
+         << "                      elsewhere the same as --functional)\n"
+         << "  --jit-check         run the JIT and the interpreter side by side and compare\n"
+         << "                      architectural state every 4096 instructions\n"
+         << "Pipeline options (see sim_config.hpp):\n"
+         << "  --forwarding[=0|1]  EX/MEM and MEM/WB bypass to EX (default off)\n"
+         << "  --predictor=<kind>  not-taken (default), btfn, bht or btb\n"
+         << "  --bht_entries=<n>   2-bit counters in the BHT (default 64)\n"
+         << "  --btb_entries=<n>   BTB entries (default 16)\n"
+         << "  --icache, --dcache  enable the L1 instruction / data cache model (default off)\n"
+         << "  --{i,d}cache_size=<bytes> --{i,d}cache_ways=<n> --{i,d}cache_line=<bytes>\n"
+         << "  --{i,d}cache_policy=lru|fifo|random  --dcache_write=back|through\n"
+         << "  --{i,d}cache_hit_latency=<cycles> --{i,d}cache_miss_latency=<cycles>\n"
+         << "  --mul_latency=<n>   cycles to a MUL* result, pipelined (default 3)\n"
+         << "  --div_latency=<n>   cycles a DIV*/REM* holds EX (default 32)\n";
+}
+
+enum class RunMode { Pipeline, Functional, Jit, JitCheck, Lockstep };
+
+struct RunResult {
+    uint64_t cycles;        // 0 in functional mode
+    uint64_t instructions;
+    bool halted;
+};
+
+static RunResult runToCompletion(RISCV_Simulator& sim, uint64_t maxCycles) {
+    RunResult result = {0, 0, false};
+    while (!sim.is_halted()) {
+        if (maxCycles != 0 && result.cycles >= maxCycles) break;
+        sim.step();
+        result.cycles++;
+    }
+    result.instructions = sim.get_retired();
+    result.halted = sim.is_halted();
+    return result;
+}
+
+static RunResult runFunctional(RISCV_Simulator& sim, uint64_t maxInstructions, bool jit) {
+    RunResult result = {0, 0, false};
+    result.instructions = jit ? sim.run_jit(maxInstructions) : sim.run_functional(maxInstructions);
+    result.halted = sim.is_halted();
+    return result;
+}
+
+static void writeCacheStats(ostream& out, const char* name, const CacheStats& s, uint64_t stallCycles) {
+    out << name << ": " << s.accesses() << " accesses (" << s.reads << " reads, " << s.writes << " writes), "
+        << s.hits << " hits, " << s.misses << " misses, hit rate " << fixed << setprecision(1)
+        << s.hit_rate() * 100.0 << "%, " << s.evictions << " evictions, " << s.writebacks << " writebacks, "
+        << stallCycles << " stall cycles\n";
+    out.unsetf(ios::floatfield);
+}
+
+static void writeState(ostream& out, const string& filename, const RISCV_Simulator& sim, const RunResult& run) {
+    out << "== " << filename << " ==\n";
+    if (run.cycles != 0 || run.instructions == 0) out << "cycles: " << run.cycles << "\n";
+    out << "instructions: " << run.instructions << (run.halted ? "" : " (limit reached)") << "\n";
+    out << "pc: 0x" << hex << setw(8) << setfill('0') << sim.get_pc() << dec << setfill(' ') << "\n";
+
+    if (run.cycles != 0) {
+        PerfCounters c = sim.get_counters();
+        out << fixed << setprecision(3) << "cpi: " << c.cpi() << "  ipc: " << c.ipc() << "\n";
+        out.unsetf(ios::floatfield);
+        out << "raw stalls: " << c.raw_stalls() << " (ex " << c.raw_stalls_ex << ", mem " << c.raw_stalls_mem
+            << ", wb " << c.raw_stalls_wb << "), control flushes: " << c.control_flushes
+            << ", bubbles: " << c.bubbles << "\n";
+        out << "loads: " << c.loads << ", stores: " << c.stores << "\n";
+        if (c.muldiv != 0) {
+            out << "mul/div: " << c.muldiv << " (mul " << sim.get_config().mul_latency << " cycles, div "
+                << sim.get_config().div_latency << " cycles), ex busy stalls: " << c.ex_busy_stalls << "\n";
+        }
+
+        const PredictorStats& branches = sim.get_predictor_stats();
+        if (branches.branches != 0) {
+            out << "branches: " << branches.branches << " (" << branches.taken << " taken), "
+                << branches.mispredicts << " mispredicted, accuracy " << fixed << setprecision(1)
+                << branches.accuracy() * 100.0 << "% [" << predictorKindName(sim.get_config().predictor) << "]\n";
+            out.unsetf(ios::floatfield);
+        }
+        if (sim.get_config().icache.enabled) writeCacheStats(out, "icache", sim.get_icache_stats(), c.icache_stall_cycles);
+        if (sim.get_config().dcache.enabled) writeCacheStats(out, "dcache", sim.get_dcache_stats(), c.dcache_stall_cycles);
+    }
+
+    out << "registers:\n";
+    for (int i = 0; i < 32; i++) {
+        int32_t value = sim.get_reg(i);
+        out << "  x" << left << setw(2) << i << right << " = " << value
+            << " (0x" << hex << setw(8) << setfill('0') << (uint32_t)value << dec << setfill(' ') << ")\n";
+    }
+
+    out << "memory (non-zero words):\n";
+    sim.get_memory().for_each_page([&out](uint32_t base, const uint8_t* bytes) {
+        for (uint32_t off = 0; off < SparseMemory::PAGE_SIZE; off += 4) {
+            int32_t word = bytes[off] | (bytes[off + 1] << 8) | (bytes[off + 2] << 16) | (bytes[off + 3] << 24);
+            if (word == 0) continue;
+            out << "  0x" << hex << setw(8) << setfill('0') << base + off << dec << setfill(' ')
+                << ": " << word << " (0x" << hex << setw(8) << setfill('0') << (uint32_t)word << dec << setfill(' ') << ")\n";
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    vector<string> files;
+    string outputPath;
+    uint64_t maxCycles = 0;
+    TraceLevel traceLevel = TraceLevel::Off;
+    RunMode mode = RunMode::Pipeline;
+    SimulatorConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--max-cycles" && i + 1 < argc) {
+            maxCycles = stoull(argv[++i]);
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            if (!parseTraceLevel(arg.substr(8), traceLevel)) {
+                cerr << "ERROR: Unknown trace level " << arg.substr(8) << endl;
+                return 1;
+            }
+        } else if (arg == "--functional") {
+            mode = RunMode::Functional;
+        } else if (arg == "--lockstep") {
+            mode = RunMode::Lockstep;
+        } else if (arg == "--jit") {
+            mode = RunMode::Jit;
+        } else if (arg == "--jit-check") {
+            mode = RunMode::JitCheck;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.rfind("--", 0) == 0) {
+            // Anything else is a simulator option: --key or --key=value
+            size_t eq = arg.find('=');
+            string key = arg.substr(2, eq == string::npos ? string::npos : eq - 2);
+            string value = (eq == string::npos) ? "1" : arg.substr(eq + 1);
+            string error;
+            if (!applySimulatorOption(config, key, value, error)) {
+                cerr << "ERROR: " << error << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            cerr << "ERROR: Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    string configError;
+    if (!validateSimulatorConfig(config, configError)) {
+        cerr << "ERROR: " << configError << endl;
+        return 1;
+    }
+
+    ofstream outFile;
+    if (!outputPath.empty()) {
+        outFile.open(outputPath);
+        if (!outFile.is_open()) {
+            cerr << "ERROR: Could not open output file " << outputPath << endl;
+            return 1;
+        }
+    }
+    ostream& out = outputPath.empty() ? cout : outFile;
+
+    int exitCode = 0;
+    for (const string& filename : files) {
+        Program program;
+        try {
+            program = assembleFile(filename);
+        } catch (const std::exception& e) {
+            cerr << "ERROR: " << e.what() << endl;
+            return 1;
+        }
+        Session session(program, config);
+        RISCV_Simulator& sim = session.simulator();
+        sim.set_trace(traceLevel);
+
+        if (mode == RunMode::Functional || mode == RunMode::Jit) {
+            RunResult run = runFunctional(sim, maxCycles, mode == RunMode::Jit);
+            writeState(out, filename, sim, run);
+            if (!run.halted) exitCode = 2;
+        } else if (mode == RunMode::JitCheck) {
+            Session reference(program, config);
+            JitCheckResult check = run_jit_check(sim, reference.simulator(), 4096, maxCycles);
+            RunResult run = {0, check.retired, check.halted};
+            writeState(out, filename, sim, run);
+            if (check.ok) {
+                out << "jit-check: OK (" << check.retired << " instructions, " << sim.get_compiled_blocks()
+                    << " blocks compiled" << (JitCache::supported() ? "" : ", no JIT on this host") << ")\n";
+            } else {
+                out << "jit-check: MISMATCH at " << check.mismatch << "\n";
+                exitCode = 3;
+            }
+            if (check.ok && !check.halted) exitCode = 2;
+        } else if (mode == RunMode::Lockstep) {
+            Session reference(program, config);
+            reference.simulator().set_trace(TraceLevel::Off);
+            LockstepResult lockstep = run_lockstep(sim, reference.simulator(), maxCycles);
+            RunResult run = {lockstep.cycles, lockstep.retired, lockstep.halted};
+            writeState(out, filename, sim, run);
+            if (lockstep.ok) {
+                out << "lockstep: OK (" << lockstep.retired << " retirements matched)\n";
+            } else if (!lockstep.mismatch.empty()) {
+                out << "lockstep: MISMATCH at " << lockstep.mismatch << "\n";
+                exitCode = 3;
+            } else {
+                exitCode = 2;
+            }
+        } else {
+            RunResult run = runToCompletion(sim, maxCycles);
+            writeState(out, filename, sim, run);
+            if (!run.halted) exitCode = 2;
+        }
+    }
+    return exitCode;
+}
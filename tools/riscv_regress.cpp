@@ -0,0 +1,156 @@
+// Golden-state regression runner: splits corpus files into cases (regression.hpp),
+// runs every case concurrently and checks the `# expect:` annotations.
+//   exit 0: all passed   1: failures   3: at least one cycle-count regression
+#include "../hpp_files/regression.hpp"
+#include "../hpp_files/assembler.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+static void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << " [options] <corpus | dir ...>\n"
+         << "Options:\n"
+         << "  -j <n>              worker threads (default: one per core)\n"
+         << "  --max-cycles <n>    fail a case that has not halted after n cycles (default 1000000)\n"
+         << "  --ignore-cycles     check final state only (for options the annotations were not written for)\n"
+         << "  -v                  list passing cases too\n"
+         << "  any riscv_cli pipeline option (--forwarding, --predictor=..., --icache, ...)\n"
+         << "A directory contributes its .s files; a corpus file may hold several cases.\n";
+}
+
+int main(int argc, char** argv) {
+    vector<string> inputs;
+    unsigned threads = thread::hardware_concurrency();
+    uint64_t maxCycles = 1000000;
+    bool checkCycles = true;
+    bool verbose = false;
+    SimulatorConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if ((arg == "-j" || arg == "--max-cycles") && i + 1 < argc) {
+            string value = argv[++i];
+            try {
+                // Like sim_config's counts: digits only, as stoul would stop at the first other character
+                if (value.find_first_not_of("0123456789") != string::npos) throw invalid_argument(value);
+                if (arg == "-j") threads = (unsigned)stoul(value);
+                else maxCycles = stoull(value);
+            } catch (const std::exception&) {
+                cerr << "ERROR: Invalid value '" << value << "' for " << arg << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--ignore-cycles") {
+            checkCycles = false;
+        } else if (arg == "-v") {
+            verbose = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            string key = arg.substr(2, eq == string::npos ? string::npos : eq - 2);
+            string value = (eq == string::npos) ? "1" : arg.substr(eq + 1);
+            string error;
+            if (!applySimulatorOption(config, key, value, error)) {
+                cerr << "ERROR: " << error << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            cerr << "ERROR: Unknown option " << arg << endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    string configError;
+    if (!validateSimulatorConfig(config, configError)) {
+        cerr << "ERROR: " << configError << endl;
+        return 1;
+    }
+
+    vector<string> files;
+    for (const string& input : inputs) {
+        if (!filesystem::is_directory(input)) {
+            files.push_back(input);
+            continue;
+        }
+        vector<string> found;
+        for (const auto& entry : filesystem::directory_iterator(input)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".s") found.push_back(entry.path().string());
+        }
+        sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    if (files.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    vector<RegressionCase> cases;
+    for (const string& file : files) {
+        ifstream in(file);
+        if (!in.is_open()) {
+            cerr << "ERROR: Could not open file " << file << endl;
+            return 1;
+        }
+        string error;
+        if (!splitCorpus(in, file, cases, error)) {
+            cerr << "ERROR: " << error << endl;
+            return 1;
+        }
+    }
+    if (cases.empty()) {
+        cerr << "ERROR: No cases found" << endl;
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+    if (threads > cases.size()) threads = (unsigned)cases.size();
+
+    // Workers claim the next unstarted case until none are left
+    vector<RegressionResult> results(cases.size());
+    atomic<size_t> next(0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&]() {
+            for (size_t i = next++; i < cases.size(); i = next++) {
+                results[i] = runRegressionCase(cases[i], config, maxCycles, checkCycles);
+            }
+        });
+    }
+    for (thread& worker : pool) worker.join();
+    double wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    size_t passed = 0, regressions = 0, unchecked = 0;
+    for (size_t i = 0; i < cases.size(); i++) {
+        const RegressionCase& c = cases[i];
+        const RegressionResult& r = results[i];
+        bool annotated = !c.regs.empty() || !c.mem.empty() || c.check_cycles || c.check_instret;
+        if (!annotated) unchecked++;
+        if (r.passed) passed++;
+        if (r.cycle_regression) regressions++;
+        if (r.passed && !verbose) continue;
+
+        cout << (r.passed ? "PASS " : r.cycle_regression ? "REGRESSION " : "FAIL ")
+             << c.file << ":" << c.line << " " << c.name << " (" << r.cycles << " cycles"
+             << (annotated ? "" : ", no expectations") << ")";
+        if (!r.passed) cout << "\n    " << r.failures;
+        cout << "\n";
+    }
+
+    cout << fixed << setprecision(1)
+         << passed << "/" << cases.size() << " cases passed";
+    if (unchecked) cout << " (" << unchecked << " without expectations)";
+    cout << ", " << threads << " threads, " << wall * 1000.0 << " ms\n";
+    if (regressions) {
+        cout << "*** " << regressions << " CYCLE-COUNT REGRESSION" << (regressions > 1 ? "S" : "")
+             << ": a case now takes more cycles than its annotation ***\n";
+        return 3;
+    }
+    return passed == cases.size() ? 0 : 1;
+}